@@ -0,0 +1,118 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file arena.c
+ *
+ * @brief Implementation of arena allocator
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+arena_t arena;
+
+// size of object rounded up to alignment
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// block header is rounded too, so objects in block stay aligned
+#define ARENA_HEADER ARENA_ROUND(sizeof(arena_block_t))
+
+// index of free list for object of (rounded) size
+#define ARENA_CLASS(size) ((size) <= ARENA_CLASSES * ARENA_ALIGN ? \
+        (size) / ARENA_ALIGN - 1 : ARENA_CLASSES)
+
+/**
+ * @brief Allocate new block big enough for object of given size
+ */
+static void *arena_new_block(arena_t *a, size_t size)
+{
+    size_t block_size = ARENA_HEADER + size;
+
+    if (block_size <= ARENA_BLOCK_SIZE) {
+        block_size = ARENA_BLOCK_SIZE;
+    }
+
+    arena_block_t *block = malloc(block_size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->size = block_size;
+    a->blocks++;
+
+    char *object = (char *)block + ARENA_HEADER;
+    if (block_size == ARENA_BLOCK_SIZE) {
+        // continue in new block, rest of the old block is abandoned
+        block->next = a->block;
+        a->block = block;
+        a->cur = object + size;
+        a->end = (char *)block + block_size;
+    } else {
+        // big object gets its own block, current block is kept
+        if (a->block) {
+            block->next = a->block->next;
+            a->block->next = block;
+        } else {
+            block->next = NULL;
+            a->block = block;
+        }
+    }
+
+    return object;
+}
+
+void *arena_alloc(arena_t *a, size_t size)
+{
+    size = ARENA_ROUND(size ? size : 1);
+    a->objects++;
+
+    // reuse object of the same size
+    arena_free_t **list = &a->free[ARENA_CLASS(size)];
+    if (size > ARENA_CLASSES * ARENA_ALIGN) {
+        while (*list != NULL && (*list)->size != size) {
+            list = &(*list)->next;
+        }
+    }
+    if (*list != NULL) {
+        arena_free_t *object = *list;
+        *list = object->next;
+        return object;
+    }
+
+    if ((size_t)(a->end - a->cur) >= size) {
+        void *object = a->cur;
+        a->cur += size;
+        return object;
+    }
+
+    return arena_new_block(a, size);
+}
+
+void arena_free(arena_t *a, void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    size = ARENA_ROUND(size ? size : 1);
+    arena_free_t *object = ptr;
+    object->size = size;
+    object->next = a->free[ARENA_CLASS(size)];
+    a->free[ARENA_CLASS(size)] = object;
+}
+
+void arena_release(arena_t *a)
+{
+    while (a->block != NULL) {
+        arena_block_t *next = a->block->next;
+        free(a->block);
+        a->block = next;
+    }
+
+    memset(a, 0, sizeof(*a));
+}
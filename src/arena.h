@@ -0,0 +1,79 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file arena.h
+ *
+ * @brief Arena allocator for objects which live at most until end of compilation
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)   // size of one malloc'd block
+#define ARENA_ALIGN 16                  // alignment of every object
+#define ARENA_CLASSES 16                // free lists for sizes 16, 32, ... 256
+
+/**
+ * @brief Block of memory from which objects are cut
+ */
+typedef struct arena_block {
+    struct arena_block *next;   // previously allocated block
+    size_t size;                // size of whole block
+} arena_block_t;
+
+/**
+ * @brief Object returned by arena_free(), reused by next arena_alloc()
+ */
+typedef struct arena_free {
+    struct arena_free *next;
+    size_t size;                // size of object (for objects above classes)
+} arena_free_t;
+
+/**
+ * @brief Objects are allocated by moving pointer in current block, they
+ *  are released all at once by arena_release()
+ */
+typedef struct arena {
+    arena_block_t *block;       // list of all blocks, current block first
+    char *cur;                  // free space of current block
+    char *end;
+    arena_free_t *free[ARENA_CLASSES + 1];  // last list holds bigger objects
+    size_t blocks;              // number of malloc calls made by arena
+    size_t objects;             // number of objects handed out
+} arena_t;
+
+extern arena_t arena;   // arena of current compilation
+
+/**
+ * @brief Allocate object of given size aligned to ARENA_ALIGN
+ *
+ * @param a Arena
+ * @param size Size of object
+ *
+ * @return Pointer to object, NULL if allocation of new block failed
+ */
+void *arena_alloc(arena_t *a, size_t size);
+
+/**
+ * @brief Return object to arena before release, so it can be reused by
+ *  arena_alloc() of the same size (memory is not given back to system)
+ *
+ * @param a Arena
+ * @param ptr Object allocated by arena_alloc()
+ * @param size Size which was passed to arena_alloc()
+ */
+void arena_free(arena_t *a, void *ptr, size_t size);
+
+/**
+ * @brief Free all blocks of arena, every object of arena is invalid afterwards
+ */
+void arena_release(arena_t *a);
+
+#endif // _ARENA_H_
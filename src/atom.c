@@ -0,0 +1,103 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file atom.c
+ *
+ * @brief Implementation of table of interned identifiers
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "atom.h"
+#include "arena.h"
+
+// table of all atoms, grows when it gets more atoms than buckets
+static struct {
+    atom_t **bucket;
+    uint32_t size;
+    uint32_t count;
+} atoms = {NULL, 0, 0};
+
+static uint32_t atom_hash(const char *str, unsigned int length)
+{
+    uint32_t h = 0;
+    const unsigned char *p = (const unsigned char *)str;
+    for (unsigned int i = 0; i < length; i++)
+        h = 65599*h + p[i];
+    return h;
+}
+
+/**
+ * @brief Double number of buckets and move all atoms into new buckets
+ */
+static int atom_grow()
+{
+    uint32_t size = atoms.size ? atoms.size * 2 : ATOM_TABLE_SIZE;
+    atom_t **bucket = calloc(size, sizeof(*bucket));
+    if (bucket == NULL) {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < atoms.size; i++) {
+        atom_t *atom = atoms.bucket[i];
+        while (atom != NULL) {
+            atom_t *next = atom->next;
+            atom->next = bucket[atom->hash & (size - 1)];
+            bucket[atom->hash & (size - 1)] = atom;
+            atom = next;
+        }
+    }
+
+    free(atoms.bucket);
+    atoms.bucket = bucket;
+    atoms.size = size;
+
+    return 0;
+}
+
+atom_t *atom_intern(const char *str, unsigned int length)
+{
+    if (atoms.count >= atoms.size && atom_grow()) {
+        return NULL;
+    }
+
+    uint32_t hash = atom_hash(str, length);
+    atom_t **bucket = &atoms.bucket[hash & (atoms.size - 1)];
+
+    for (atom_t *atom = *bucket; atom != NULL; atom = atom->next) {
+        if (atom->hash == hash && atom->name.length == length &&
+                !memcmp(atom->data, str, length)) {
+            return atom;
+        }
+    }
+
+    // first occurence of name, create new atom
+    atom_t *atom = arena_alloc(&arena, sizeof(*atom) + length + 1);
+    if (atom == NULL) {
+        return NULL;
+    }
+
+    memcpy(atom->data, str, length);
+    atom->data[length] = '\0';
+    atom->name = str_view(atom->data, length);
+    atom->hash = hash;
+    atom->next = *bucket;
+    *bucket = atom;
+    atoms.count++;
+
+    return atom;
+}
+
+void atom_destroy()
+{
+    // atoms themselves are released with arena
+    free(atoms.bucket);
+    atoms.bucket = NULL;
+    atoms.size = 0;
+    atoms.count = 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file atom.h
+ *
+ * @brief Table of interned identifiers (atoms)
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _ATOM_H_
+#define _ATOM_H_
+
+#include <stdint.h>
+#include "str.h"
+
+#define ATOM_TABLE_SIZE 1024   // initial number of buckets (power of 2)
+
+/**
+ * @brief Interned identifier, every name has exactly one atom, so two names
+ *  are equal if and only if their atoms are the same pointer
+ */
+typedef struct atom {
+    string_t name;          // name ended with '\0' (view into data, never freed)
+    uint32_t hash;          // precomputed hash of name
+    struct atom *next;      // next atom in the same bucket
+    char data[];            // characters of name
+} atom_t;
+
+/**
+ * @brief Find atom for given characters, create it if it does not exist yet
+ *
+ * @param str Characters of name (do not have to be ended with '\0')
+ * @param length Number of characters
+ *
+ * @return Pointer to atom, NULL if allocation failed
+ */
+atom_t *atom_intern(const char *str, unsigned int length);
+
+/**
+ * @brief Free table of atoms, atoms are allocated in arena, so pointers to
+ *  them are valid until arena_release()
+ */
+void atom_destroy();
+
+#endif // _ATOM_H_
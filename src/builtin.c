@@ -13,15 +13,21 @@
 
 #include <string.h>
 #include "builtin.h"
+#include "arena.h"
 #include "generator.h"
 #include "ibuffer.h"
 #include "str.h"
 
 extern ibuffer_t *buffer;           // instruction buffer from parser
 
+// operands of builtin functions
+#define LF(name) opd_var_name(FRAME_LF, name)
+#define LABEL(name) opd_label_name(name)
+#define STRING(str) opd_string(atom_intern(str, strlen(str)))
+
 builtin_used_t *builtin_used_create()
 {
-    builtin_used_t *bu = malloc(sizeof(*bu));
+    builtin_used_t *bu = arena_alloc(&arena, sizeof(*bu));
     if (bu == NULL) {
         return NULL;
     }
@@ -39,97 +45,71 @@ builtin_used_t *builtin_used_create()
 
 void add_builtin(global_symtab_t *gs)
 {
-    string_t function_name;
-    str_init(&function_name);
-
     // reads
-    str_insert(&function_name, "reads");
-    struct global_item *func = global_add(gs, function_name);
+    struct global_item *func = global_add(gs, atom_intern("reads", 5));
     func->defined = true;
     str_add_char(&func->retvals, 's');
-    str_clear(&function_name);
 
     // readi
-    str_insert(&function_name, "readi");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("readi", 5));
     func->defined = true;
     str_add_char(&func->retvals, 'i');
-    str_clear(&function_name);
 
     // readn
-    str_insert(&function_name, "readn");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("readn", 5));
     func->defined = true;
     str_add_char(&func->retvals, 'n');
-    str_clear(&function_name);
 
     // write
-    str_insert(&function_name, "write");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("write", 5));
     func->defined = true;
-    str_clear(&function_name);
 
     // tointeger
-    str_insert(&function_name, "tointeger");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("tointeger", 9));
     func->defined = true;
     str_add_char(&func->retvals, 'i');
     str_add_char(&func->params, 'n');
-    str_clear(&function_name);
 
     // substr
-    str_insert(&function_name, "substr");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("substr", 6));
     func->defined = true;
     str_add_char(&func->retvals, 's');
     str_insert(&func->params, "snn");
-    str_clear(&function_name);
 
     // ord
-    str_insert(&function_name, "ord");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("ord", 3));
     func->defined = true;
     str_add_char(&func->retvals, 'i');
     str_insert(&func->params, "si");
-    str_clear(&function_name);
 
     // chr
-    str_insert(&function_name, "chr");
-    func = global_add(gs, function_name);
+    func = global_add(gs, atom_intern("chr", 3));
     func->defined = true;
     str_add_char(&func->retvals, 's');
     str_add_char(&func->params, 'i');
-    str_clear(&function_name);
-
-    str_free(&function_name);
 }
 
 
 
-void builtin_used_update(builtin_used_t *bu, string_t name)
+void builtin_used_update(builtin_used_t *bu, atom_t *name)
 {
-    if (!strcmp(name.str, "reads")) {
+    if (!strcmp(name->name.str, "reads")) {
         bu->reads = true;
-    } else if (!strcmp(name.str, "readn")) {
+    } else if (!strcmp(name->name.str, "readn")) {
         bu->readn = true;
-    } else if (!strcmp(name.str, "readi")) {
+    } else if (!strcmp(name->name.str, "readi")) {
         bu->readi = true;
-    } else if (!strcmp(name.str, "tointeger")) {
+    } else if (!strcmp(name->name.str, "tointeger")) {
         bu->tointeger = true;
-    } else if (!strcmp(name.str, "substr")) {
+    } else if (!strcmp(name->name.str, "substr")) {
         bu->substr = true;
-    } else if (!strcmp(name.str, "ord")) {
+    } else if (!strcmp(name->name.str, "ord")) {
         bu->ord = true;
-    } else if (!strcmp(name.str, "chr")) {
+    } else if (!strcmp(name->name.str, "chr")) {
         bu->chr = true;
     }
 }
 
-void builtin_destroy(builtin_used_t *bu)
-{
-    free(bu);
-}
-
 void generate_builtin(builtin_used_t *bu)
 {
     if (bu->reads) {
@@ -158,212 +138,212 @@ void generate_builtin(builtin_used_t *bu)
 
 void generate_reads()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label reads");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("read LF@%retval0 string");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("reads"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_READ, LF("%retval0"), opd_type("string"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_readi()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label readi");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("read LF@%retval0 int");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("readi"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_READ, LF("%retval0"), opd_type("int"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_readn()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label readn");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("read LF@%retval0 float");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("readn"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_READ, LF("%retval0"), opd_type("float"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_chr()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label chr");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("move LF@%retval0 nil@nil");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("chr"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_MOVE, LF("%retval0"), opd_nil());
 
     // variable to chceck if parameter is not nil
-    ADD_INST_N("defvar LF@%param_type");
-    ADD_INST_N("type LF@%param_type LF@%0");
+    ADD_INST1(OP_DEFVAR, LF("%param_type"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%0"));
 
-    ADD_INST_N("jumpifeq _not_nil LF@%param_type string@int");
-    ADD_INST_N("exit int@8");
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_not_nil"), LF("%param_type"), STRING("int"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
     // retval is not nil
-    ADD_INST_N("label _not_nil");
-    ADD_INST_N("defvar LF@%bool");
+    ADD_INST1(OP_LABEL, LABEL("_not_nil"));
+    ADD_INST1(OP_DEFVAR, LF("%bool"));
 
     // 0 < i < 255
-    ADD_INST_N("lt LF@%bool LF@%0 int@0");
-    ADD_INST_N("jumpifeq _chr_end LF@%bool bool@true");
-    ADD_INST_N("gt LF@%bool LF@%0 int@255");
-    ADD_INST_N("jumpifeq _chr_end LF@%bool bool@true");
+    ADD_INST3(OP_LT, LF("%bool"), LF("%0"), opd_int(0));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_chr_end"), LF("%bool"), opd_bool(true));
+    ADD_INST3(OP_GT, LF("%bool"), LF("%0"), opd_int(255));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_chr_end"), LF("%bool"), opd_bool(true));
 
-    ADD_INST_N("int2char LF@%retval0 LF@%0");
+    ADD_INST2(OP_INT2CHAR, LF("%retval0"), LF("%0"));
 
-    ADD_INST_N("label _chr_end");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_INST1(OP_LABEL, LABEL("_chr_end"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_ord()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label ord");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("move LF@%retval0 nil@nil");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("ord"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_MOVE, LF("%retval0"), opd_nil());
 
     // check if parameters are not nil
-    ADD_INST_N("defvar LF@%param_type");
-    ADD_INST_N("type LF@%param_type LF@%0");
-    ADD_INST_N("jumpifeq _ord_par2 LF@%param_type string@string");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_DEFVAR, LF("%param_type"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%0"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_ord_par2"), LF("%param_type"), STRING("string"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
-    ADD_INST_N("label _ord_par2");
-    ADD_INST_N("type LF@%param_type LF@%1");
-    ADD_INST_N("jumpifeq _ord_cont LF@%param_type string@int");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_LABEL, LABEL("_ord_par2"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%1"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_ord_cont"), LF("%param_type"), STRING("int"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
     // parameters are not nil
-    ADD_INST_N("label _ord_cont");
-    ADD_INST_N("defvar LF@%strlen");
-    ADD_INST_N("strlen LF@%strlen LF@%0");
-    ADD_INST_N("sub LF@%strlen LF@%strlen int@1");
+    ADD_INST1(OP_LABEL, LABEL("_ord_cont"));
+    ADD_INST1(OP_DEFVAR, LF("%strlen"));
+    ADD_INST2(OP_STRLEN, LF("%strlen"), LF("%0"));
+    ADD_INST3(OP_SUB, LF("%strlen"), LF("%strlen"), opd_int(1));
 
     // check if index is in range 0 < i - 1 < strlen - 1
-    ADD_INST_N("sub LF@%1 LF@%1 int@1");
-    ADD_INST_N("defvar LF@%bool");
-    ADD_INST_N("lt LF@%bool LF@%1 int@0");
-    ADD_INST_N("jumpifeq _ord_end LF@%bool bool@true");
-    ADD_INST_N("gt LF@%bool LF@%1 LF@%strlen");
-    ADD_INST_N("jumpifeq _ord_end LF@%bool bool@true");
-
-    ADD_INST_N("stri2int LF@%retval0 LF@%0 LF@%1");
-
-    ADD_INST_N("label _ord_end");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_INST3(OP_SUB, LF("%1"), LF("%1"), opd_int(1));
+    ADD_INST1(OP_DEFVAR, LF("%bool"));
+    ADD_INST3(OP_LT, LF("%bool"), LF("%1"), opd_int(0));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_ord_end"), LF("%bool"), opd_bool(true));
+    ADD_INST3(OP_GT, LF("%bool"), LF("%1"), LF("%strlen"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_ord_end"), LF("%bool"), opd_bool(true));
+
+    ADD_INST3(OP_STRI2INT, LF("%retval0"), LF("%0"), LF("%1"));
+
+    ADD_INST1(OP_LABEL, LABEL("_ord_end"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_substr()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label substr");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("defvar LF@%iterator");
-    ADD_INST_N("defvar LF@%begin");
-    ADD_INST_N("defvar LF@%end");
-    ADD_INST_N("defvar LF@%char");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("substr"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST1(OP_DEFVAR, LF("%iterator"));
+    ADD_INST1(OP_DEFVAR, LF("%begin"));
+    ADD_INST1(OP_DEFVAR, LF("%end"));
+    ADD_INST1(OP_DEFVAR, LF("%char"));
 
     // check if any param is nil
-    ADD_INST_N("defvar LF@%param_type");
-    ADD_INST_N("type LF@%param_type LF@%0");
-    ADD_INST_N("jumpifeq _substr_par2 LF@%param_type string@string");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_DEFVAR, LF("%param_type"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%0"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_par2"), LF("%param_type"), STRING("string"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
-    ADD_INST_N("label _substr_par2");
-    ADD_INST_N("type LF@%param_type LF@%1");
-    ADD_INST_N("jumpifeq _substr_par3 LF@%param_type string@float");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_LABEL, LABEL("_substr_par2"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%1"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_par3"), LF("%param_type"), STRING("float"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
-    ADD_INST_N("label _substr_par3");
-    ADD_INST_N("type LF@%param_type LF@%2");
-    ADD_INST_N("jumpifeq _substr_cont LF@%param_type string@float");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_LABEL, LABEL("_substr_par3"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%2"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_cont"), LF("%param_type"), STRING("float"));
+    ADD_INST1(OP_EXIT, opd_int(8));
 
 
-    ADD_INST_N("label _substr_cont");
+    ADD_INST1(OP_LABEL, LABEL("_substr_cont"));
 
     // initialize empty retval0
-    ADD_INST_N("move LF@%retval0 string@");
+    ADD_INST2(OP_MOVE, LF("%retval0"), STRING(""));
 
     // convert given numbers into integers
-    ADD_INST_N("float2int LF@%begin LF@%1");
-    ADD_INST_N("float2int LF@%end LF@%2");
+    ADD_INST2(OP_FLOAT2INT, LF("%begin"), LF("%1"));
+    ADD_INST2(OP_FLOAT2INT, LF("%end"), LF("%2"));
 
     // substract 1 from begin, since getchar uses indexes from 0
-    ADD_INST_N("sub LF@%begin LF@%begin int@1");
+    ADD_INST3(OP_SUB, LF("%begin"), LF("%begin"), opd_int(1));
 
-    ADD_INST_N("move LF@%iterator LF@%begin");
+    ADD_INST2(OP_MOVE, LF("%iterator"), LF("%begin"));
 
     // if i > j return empty string
-    ADD_INST_N("defvar LF@%bool");
-    ADD_INST_N("gt LF@%bool LF@%iterator LF@%end");
-    ADD_INST_N("jumpifeq _substr_end LF@%bool bool@true");
+    ADD_INST1(OP_DEFVAR, LF("%bool"));
+    ADD_INST3(OP_GT, LF("%bool"), LF("%iterator"), LF("%end"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%bool"), opd_bool(true));
 
-    ADD_INST_N("defvar LF@%strlen");
-    ADD_INST_N("strlen LF@%strlen LF@%0");
+    ADD_INST1(OP_DEFVAR, LF("%strlen"));
+    ADD_INST2(OP_STRLEN, LF("%strlen"), LF("%0"));
 
     // 1 < j < strlen
-    ADD_INST_N("lt LF@%bool LF@%end int@1");
-    ADD_INST_N("jumpifeq _substr_end LF@%bool bool@true");
-    ADD_INST_N("gt LF@%bool LF@%end LF@%strlen");
-    ADD_INST_N("jumpifeq _substr_end LF@%bool bool@true");
+    ADD_INST3(OP_LT, LF("%bool"), LF("%end"), opd_int(1));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%bool"), opd_bool(true));
+    ADD_INST3(OP_GT, LF("%bool"), LF("%end"), LF("%strlen"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%bool"), opd_bool(true));
 
     // 0 < i - 1 < strlen - 1
-    ADD_INST_N("sub LF@%strlen LF@%strlen int@1");
-    ADD_INST_N("lt LF@%bool LF@%begin int@0");
-    ADD_INST_N("jumpifeq _substr_end LF@%bool bool@true");
-    ADD_INST_N("gt LF@%bool LF@%begin LF@%strlen");
-    ADD_INST_N("jumpifeq _substr_end LF@%bool bool@true");
+    ADD_INST3(OP_SUB, LF("%strlen"), LF("%strlen"), opd_int(1));
+    ADD_INST3(OP_LT, LF("%bool"), LF("%begin"), opd_int(0));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%bool"), opd_bool(true));
+    ADD_INST3(OP_GT, LF("%bool"), LF("%begin"), LF("%strlen"));
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%bool"), opd_bool(true));
 
-    ADD_INST_N("label _substr_loop");  //loop start
+    ADD_INST1(OP_LABEL, LABEL("_substr_loop"));  //loop start
 
     // if iterator == j, jump to end
-    ADD_INST_N("jumpifeq _substr_end LF@%iterator LF@%end");
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_substr_end"), LF("%iterator"), LF("%end"));
 
     // get single char from string and store it in LF@char
-    ADD_INST_N("getchar LF@%char LF@%0 LF@%iterator");
+    ADD_INST3(OP_GETCHAR, LF("%char"), LF("%0"), LF("%iterator"));
 
     // concatenate retval0 with newly extracted char
-    ADD_INST_N("concat LF@%retval0 LF@%retval0 LF@%char");
+    ADD_INST3(OP_CONCAT, LF("%retval0"), LF("%retval0"), LF("%char"));
 
-    ADD_INST_N("add LF@%iterator LF@%iterator int@1");
-    ADD_INST_N("jump _substr_loop");
+    ADD_INST3(OP_ADD, LF("%iterator"), LF("%iterator"), opd_int(1));
+    ADD_INST1(OP_JUMP, LABEL("_substr_loop"));
 
-    ADD_INST_N("label _substr_end");
+    ADD_INST1(OP_LABEL, LABEL("_substr_end"));
 
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_tointeger()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label tointeger");
-    ADD_INST_N("pushframe");
-    ADD_INST_N("defvar LF@%retval0");
-    ADD_INST_N("move LF@%retval0 nil@nil");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, LABEL("tointeger"));
+    ADD_INST0(OP_PUSHFRAME);
+    ADD_INST1(OP_DEFVAR, LF("%retval0"));
+    ADD_INST2(OP_MOVE, LF("%retval0"), opd_nil());
 
     // variable to chceck if param_type is not nil
-    ADD_INST_N("defvar LF@%param_type");
-    ADD_INST_N("type LF@%param_type LF@%0");
+    ADD_INST1(OP_DEFVAR, LF("%param_type"));
+    ADD_INST2(OP_TYPE, LF("%param_type"), LF("%0"));
 
-    ADD_INST_N("jumpifeq _tointeger_cont LF@%param_type string@float");
-    ADD_INST_N("jump _tointeger_end");
+    ADD_INST3(OP_JUMPIFEQ, LABEL("_tointeger_cont"), LF("%param_type"), STRING("float"));
+    ADD_INST1(OP_JUMP, LABEL("_tointeger_end"));
 
     // retval is not nil
-    ADD_INST_N("label _tointeger_cont");
-    ADD_INST_N("float2int LF@%retval0 LF@%0");
+    ADD_INST1(OP_LABEL, LABEL("_tointeger_cont"));
+    ADD_INST2(OP_FLOAT2INT, LF("%retval0"), LF("%0"));
 
-    ADD_INST_N("label _tointeger_end");
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_INST1(OP_LABEL, LABEL("_tointeger_end"));
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
@@ -40,7 +40,7 @@ builtin_used_t *builtin_used_create();
  * @param bu Pointer to buildin_used structure
  * @param name Name of used function
  */
-void builtin_used_update(builtin_used_t *bu, string_t name);
+void builtin_used_update(builtin_used_t *bu, atom_t *name);
 
 /**
  * @brief Generate used builtin functions
@@ -54,11 +54,6 @@ void generate_builtin(builtin_used_t *bu);
  */
 void add_builtin(global_symtab_t *gs);
 
-/**
- * @brief Destroy builtin structure
- * @param bu Pointer to builtin structure
- */
-void builtin_destroy(builtin_used_t *bu);
 
 void generate_reads();
 void generate_readi();
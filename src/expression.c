@@ -150,7 +150,7 @@ prec_table_index_t symbol_to_index(int symbol)
     return rv;
 }
 
-int reduce(stack_t *stack)
+int reduce(stack_t *stack, int type)
 {
     int count = items_to_handle(stack);
     stack_item_t *top = stack_top(stack);
@@ -162,7 +162,7 @@ int reduce(stack_t *stack)
     } else if (count == 2 ) {
         if (top->data == NON_TERM && top->next->data == STR_LEN){
             // unary operator #
-            generate_push_operator(top->next->data);
+            generate_push_operator(top->next->data, type);
         } else {
             return ERROR_SYNTAX;
         }
@@ -170,7 +170,7 @@ int reduce(stack_t *stack)
         if (top->data == NON_TERM && top->next->next->data == NON_TERM) {
             if (top->next->data >= MUL && top->next->data <= GREAT_EQ) {
                 // binary operators
-                generate_push_operator(top->next->data);
+                generate_push_operator(top->next->data, type);
             }
         } else if (top->data == RIGHT_BR && top->next->next->data == LEFT_BR) {
             if (!(top->next->data == NON_TERM)) {
@@ -247,7 +247,7 @@ int check_semantic(token_t *token, stack_t *stack, int *type)
             top = stack_top(stack);
             // skip if ID ID
             if (!((top->data >= ID && top->data <= STR) || top->data == RIGHT_BR || top->data == NON_TERM)) {
-                check_id = local_find(local_tab, token->attribute.s);
+                check_id = local_find(local_tab, token->attribute.id);
                 if(check_id) {
                     if (*type == T_NONE) {
                         if (check_id->type == INT_T) {
@@ -287,7 +287,7 @@ int check_semantic(token_t *token, stack_t *stack, int *type)
                             }
                         }
                     }
-                } else if (!global_find(global_tab, token->attribute.s)) {
+                } else if (!global_find(global_tab, token->attribute.id)) {
                     // ID is not a function => variable doesn't exist
                     return ERROR_SEMANTIC;
                 }
@@ -368,14 +368,14 @@ void push_operand(token_t *token, int *type)
         // convert current token to number
         generate_int_to_num();
     } else if (token->type == TOK_ID) {
-        id = local_find(local_tab, token->attribute.s);
+        id = local_find(local_tab, token->attribute.id);
         if (id->type == INT_T && *type == T_NUM) {
             generate_int_to_num();
         }
     }
 }
 
-int expression(token_t **return_token)
+int expression()
 {
     int end = 0;
     int ret_val = SUCCESS;
@@ -385,20 +385,16 @@ int expression(token_t **return_token)
     stack_t stack_prec;
     stack_init(&stack_prec);
     stack_push(&stack_prec, DOLLAR);
+    generate_expr_init();
 
-    token_t *new_token = malloc(sizeof(token_t));
-    if (!new_token) {
-        return ERROR_INTERNAL;
-    }
+    token_t token;
+    token_t *new_token = &token;
 
     stack_item_t *top_term;
     int symbol;
     char prec_symbol;
 
-    ret_val = get_token(new_token);
-    if (ret_val) {
-        return ret_val;
-    }
+    GET_NEW_TOKEN(new_token, ret_val);
 
     top_term = stack_top_term(&stack_prec);
     symbol = token_to_symbol(new_token);
@@ -426,9 +422,8 @@ int expression(token_t **return_token)
                         (new_token->type == TOK_KEYWORD && new_token->attribute.keyword == KW_NIL) ||
                         (new_token->type >= TOK_INT && new_token->type <= TOK_STRING)) {
 
-                    if (new_token->type == TOK_ID && global_find(global_tab, new_token->attribute.s)) {
+                    if (new_token->type == TOK_ID && global_find(global_tab, new_token->attribute.id)) {
                         // ID is a function
-                        *return_token = new_token;
                         stack_dispose(&stack_prec);
                         return EC_FUNC;
                     }
@@ -446,7 +441,7 @@ int expression(token_t **return_token)
                     symbol = DOLLAR;
                 }
                 // reduce
-                ret_val = reduce(&stack_prec);
+                ret_val = reduce(&stack_prec, expr_type);
                 if (ret_val) {
                     // couldn't find rule to reduce
                     EXIT_ON_ERROR(ret_val);
@@ -467,11 +462,8 @@ int expression(token_t **return_token)
 
     if (!(stack_prec.top->data == NON_TERM && stack_prec.top->next->data == DOLLAR)) {
         // final state of stack is not $E
-        free(new_token);
         ret_val = ERROR_SYNTAX;
-        *return_token = NULL;
     } else {
-        *return_token = new_token;
         ret_val = expr_type;
     }
 
@@ -481,8 +473,10 @@ int expression(token_t **return_token)
 
 #ifdef EXPR_TEST
 int main(){
-    token_t **returned = NULL;
-    int rv = expression(returned);
+    if (token_stream_fill(&tokens))
+        return ERROR_INTERNAL;
+    int rv = expression();
+    token_stream_free(&tokens);
     return rv;
 }
 #endif
@@ -33,26 +33,18 @@
 #define T_NIL 103
 #define T_NONE 104
 
-#define FREE_STRING_TOKEN(token) \
-    do { \
-        if (token->type == TOK_STRING || token->type == TOK_ID) \
-            str_free(&token->attribute.s); \
-    } while(0);
-
 #define GET_NEW_TOKEN(token, ret) \
     do {             \
-        FREE_STRING_TOKEN(token)    \
-        ret = get_token(token); \
+        ret = token_stream_next(&tokens); \
         if (ret) {     \
-            return ret; \
+            EXIT_ON_ERROR(ret); \
         }    \
+        token_stream_get(&tokens, token); \
     } while(0);
 
 #define EXIT_ON_ERROR(ret) \
     do { \
-        free(new_token); \
         stack_dispose(&stack_prec); \
-        *return_token = NULL; \
         return ret; \
     } while(0);
 
@@ -140,10 +132,11 @@ prec_table_index_t symbol_to_index(int symbol);
  * @brief Function to perform reduction following set rules
  *
  * @param stack Initialized stack
+ * @param type Type of operands of expression found so far (T_INT, ...)
  *
  * @return Syntax error or success
  */
-int reduce(stack_t *stack);
+int reduce(stack_t *stack, int type);
 
 /**
  * @brief Function to perform semantic checks
@@ -159,14 +152,14 @@ int check_semantic(token_t *token, stack_t *stack, int *type);
 void push_operand(token_t *token, int *type);
 
 /**
- * @brief performs syntactic and semantic analysis on expression
- *
- * @param return_token last read token
+ * @brief performs syntactic and semantic analysis on expression, expression
+ *  starts with the next token of stream, current token is the first token
+ *  after expression (or function ID) when it ends
  *
  * @return Expression data type on success
  * @return ERROR_SYNTAX, ERROR_SEMANTIC, ERROR_SEMANTIC_TYPE, ERROR_NIL on failure
  * @return EC_FUNC when function ID is read
  */
-int expression(token_t **return_token);
+int expression();
 
 #endif // _EXPRESSION_H_
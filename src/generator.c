@@ -12,87 +12,209 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
 #include "generator.h"
+#include "arena.h"
+#include "nilness.h"
+#include "parser.h"
+#include "peephole.h"
 #include "str.h"
 
+// operands used by most of expressions, created by generate_start()
+static struct {
+    operand_t bool_var;             // GF@bool
+    operand_t arg1;                 // GF@arg1
+    operand_t arg2;                 // GF@arg2
+    operand_t output;               // GF@output
+    operand_t nil_type;             // string@nil (result of type instruction)
+    operand_t div_by_zero;          // labels of runtime errors
+    operand_t nil_with_operator;
+} common;
+
+// with three address code, top of expression stack is kept in compiler and
+// results of operations are stored in temporaries GF@%t<position in stack>,
+// only operands under EXPR_CACHE top operands are pushed to data stack
+static struct {
+    operand_t item[EXPR_CACHE];     // top operands, last is top of stack
+    known_t known[EXPR_CACHE];      // what is known about value of item
+    int cached;                     // operands in item
+    int depth;                      // operands in compiler and on data stack
+    int temps;                      // temporaries which need to be defined
+    size_t start;                   // first instruction of expression in buffer
+} expr;
+
+// local variables of current function, they are defined after parameters
+// when whole function was generated, with slots variables of blocks which
+// ended are reused by variables of following blocks
+static struct {
+    atom_t **name;                  // names of frame variables
+    size_t length;
+    size_t size;
+    size_t prologue;                // first instruction of function body in buffer
+} locals;
+
 /* functions for converting constants into IFJcode21 constants */
-void generate_string(string_t string)
-{
-    string_t generated;
-    str_init(&generated);
-    str_insert(&generated, "string@");
-
-    // special cases for whitespaces, hashtag and backslash
-    for (unsigned int i = 0; i < string.length; i++) {
-        if (string.str[i] <= ' ') {
-            str_insert(&generated, "\\0");
-            if (string.str[i] < 10) {
-                str_add_char(&generated, '0');
-            }
-            str_insert_int(&generated, string.str[i]);
-        } else if (string.str[i] == '#') {
-            str_insert(&generated, "\\0");
-            str_insert_int(&generated, string.str[i]);
-        } else if (string.str[i] == '\\') {
-            str_insert(&generated, "\\0");
-            str_insert_int(&generated, string.str[i]);
-        } else {
-            str_add_char(&generated, string.str[i]);
-        }
-    }
+static operand_t generate_constant(token_t *token)
+{
+    switch (token->type)
+    {
+    case TOK_STRING:
+        return opd_string(atom_intern(token->attribute.s.str, token->attribute.s.length));
 
-    strcat(INST, generated.str);
-    str_free(&generated);
+    case TOK_INT:
+        return opd_int(token->attribute.number);
+
+    case TOK_DECIMAL:
+        return opd_float(token->attribute.decimal);
+
+    case TOK_KEYWORD:
+        return opd_nil();
+
+    default:
+        return opd_none();
+    }
 }
 
-void generate_int(int number)
+// name with number appended, e.g. %retval0
+static atom_t *generate_numbered(const char *prefix, int64_t number)
 {
-    string_t generated;
-    str_init(&generated);
+    STR_BUFFERED(generated);
 
-    str_insert(&generated, "int@");
+    str_insert(&generated, (char *)prefix);
     str_insert_int(&generated, number);
 
-    strcat(INST, generated.str);
+    atom_t *atom = atom_intern(generated.str, generated.length);
     str_free(&generated);
+    return atom;
+}
+/*             END IFJCODE21 constants                    */
+
+
+/*          EXPRESSION STACK (three address code)          */
+
+// temporary for operand at given position of expression stack
+static operand_t expr_temp(int position)
+{
+    if (position >= expr.temps) {
+        expr.temps = position + 1;
+    }
+    return opd_var(FRAME_GF, generate_numbered("%t", position));
 }
 
-void generate_decimal(double number)
+static bool expr_is_temp(operand_t *opd, operand_t *temp)
 {
-    string_t generated;
-    str_init(&generated);
+    return opd->type == OPD_VAR && opd->frame == FRAME_GF && opd->val.atom == temp->val.atom;
+}
 
-    str_insert(&generated, "float@");
-    str_insert_double(&generated, number);
+static void expr_push(operand_t opd, known_t known)
+{
+    if (expr.cached == EXPR_CACHE) {
+        // bottom operand is moved to data stack
+        ADD_INST1(OP_PUSHS, expr.item[0]);
+        memmove(expr.item, expr.item + 1, (EXPR_CACHE - 1) * sizeof(operand_t));
+        memmove(expr.known, expr.known + 1, (EXPR_CACHE - 1) * sizeof(known_t));
+        expr.cached--;
+    }
+    expr.known[expr.cached] = known;
+    expr.item[expr.cached++] = opd;
+    expr.depth++;
+}
 
-    strcat(INST, generated.str);
-    str_free(&generated);
+// make sure that top count operands are in compiler, not on data stack
+static void expr_fetch(int count)
+{
+    while (expr.cached < count && expr.cached < expr.depth) {
+        operand_t temp = expr_temp(expr.depth - expr.cached - 1);
+        ADD_INST1(OP_POPS, temp);
+        memmove(expr.item + 1, expr.item, expr.cached * sizeof(operand_t));
+        memmove(expr.known + 1, expr.known, expr.cached * sizeof(known_t));
+        expr.item[0] = temp;
+        // values of operands on data stack are not remembered
+        expr.known[0] = KNOWN_NOTHING;
+        expr.cached++;
+    }
 }
 
-void generate_nil()
+static operand_t expr_pop()
 {
-    string_t generated;
-    str_init(&generated);
+    expr_fetch(1);
+    if (expr.cached == 0) {
+        // nothing was pushed, pops fails at runtime the same way as stack code
+        operand_t temp = expr_temp(0);
+        ADD_INST1(OP_POPS, temp);
+        return temp;
+    }
 
-    str_insert(&generated, "nil@nil");
+    expr.depth--;
+    return expr.item[--expr.cached];
+}
 
-    strcat(INST, generated.str);
-    str_free(&generated);
+// top of stack, NULL if expression stack is empty
+static operand_t *expr_top()
+{
+    expr_fetch(1);
+    return expr.cached ? &expr.item[expr.cached - 1] : NULL;
 }
-/*             END IFJCODE21 constants                    */
+
+// what is known about operand at position from top of stack (top is 1),
+// only with nil-ness analysis
+static known_t expr_known(int position)
+{
+    expr_fetch(position);
+    if (opt_level < OPT_LEVEL_NIL || expr.cached < position) {
+        return KNOWN_NOTHING;
+    }
+    return expr.known[expr.cached - position];
+}
+
+// constant is known exactly, other constants than nil can't be nil
+static known_t expr_constant_known(operand_t constant)
+{
+    if (constant.type == OPD_INT) {
+        return (known_t){true, constant.val.i, constant.val.i};
+    }
+    return (known_t){constant.type != OPD_NIL, INT64_MIN, INT64_MAX};
+}
+
+// pop result of expression into variable, operation which computed the
+// result into temporary writes to the variable instead
+static void expr_pop_into(operand_t var)
+{
+    operand_t result = expr_pop();
+
+    // result can be in temporary only if it was already used
+    if (buffer->length > 0 && expr.depth < expr.temps) {
+        inst_t *last = &buffer->inst[buffer->length - 1];
+        operand_t temp = expr_temp(expr.depth);
+
+        if (last->op != OP_MOVE && last->op != OP_LABEL && last->op != OP_POPS &&
+                expr_is_temp(&result, &temp) && expr_is_temp(&last->arg[0], &temp)) {
+            last->arg[0] = var;
+            return;
+        }
+    }
+    ADD_INST2(OP_MOVE, var, result);
+}
+
+/*          END EXPRESSION STACK          */
 
 
 // Function to create mangled names of identifiers in function
-void generate_name(ibuffer_t *buffer, string_t name)
+static atom_t *generate_mangled(local_symtab_t *symtab, atom_t *name)
 {
-    local_symtab_t *symtab = local_symtab_find(local_tab, name);
     if (symtab == NULL)
-        return;
+        return NULL;
 
-    string_t generated;
-    str_init(&generated);
+    // name is created only once for every variable
+    struct local_data *data = local_find_top(symtab, name);
+    if (data->mangled != NULL)
+        return data->mangled;
 
-    str_insert(&generated, local_tab->key.str);
+    STR_BUFFERED(generated);
+
+    str_insert(&generated, local_tab->key->name.str);
     str_insert(&generated, "$");
     str_insert_int(&generated, symtab->depth);
 
@@ -104,10 +226,29 @@ void generate_name(ibuffer_t *buffer, string_t name)
     }
 
     str_insert(&generated, "$");
-    str_insert(&generated, name.str);
+    str_insert_n(&generated, name->name.str, name->name.length);
 
-    strcat(INST, generated.str);
+    data->mangled = atom_intern(generated.str, generated.length);
     str_free(&generated);
+
+    return data->mangled;
+}
+
+atom_t *generate_name(atom_t *name)
+{
+    return generate_mangled(local_symtab_find(local_tab, name), name);
+}
+
+atom_t *generate_name_previous_depth(atom_t *name)
+{
+    return generate_mangled(local_symtab_find(local_tab->next, name), name);
+}
+
+// variable visible from symtable, NULL if it's not declared
+static struct local_data *generate_variable(local_symtab_t *symtab, atom_t *name)
+{
+    symtab = local_symtab_find(symtab, name);
+    return symtab != NULL ? local_find_top(symtab, name) : NULL;
 }
 
 /* Functions to generate entry points/ exit points of program */
@@ -115,275 +256,283 @@ void generate_name(ibuffer_t *buffer, string_t name)
 // generate prolog, global variables, jump to entry point
 void generate_start()
 {
-    ADD_INST_N(".IFJcode21");
+    common.bool_var = opd_var_name(FRAME_GF, "bool");
+    common.arg1 = opd_var_name(FRAME_GF, "arg1");
+    common.arg2 = opd_var_name(FRAME_GF, "arg2");
+    common.output = opd_var_name(FRAME_GF, "output");
+    common.nil_type = opd_string(atom_intern("nil", 3));
+    common.div_by_zero = opd_label_name("_div_by_zero");
+    common.nil_with_operator = opd_label_name("_nil_with_operator");
+
+    // runtime errors only exit, peephole can move code over jumps to them
+    peephole_exit_label(common.div_by_zero.val.atom);
+    peephole_exit_label(common.nil_with_operator.val.atom);
+
+    ADD_INST0(OP_HEADER);
 
     // global variable to store results of comparisons in expressions
-    ADD_INST_N("defvar GF@bool");
+    ADD_INST1(OP_DEFVAR, common.bool_var);
 
     // global variables to store operands of advanced comparisons/strlen/concat in expressions
-    ADD_INST_N("defvar GF@arg1");
-    ADD_INST_N("defvar GF@arg2");
-    ADD_INST_N("defvar GF@output");
-
-    ADD_INST_N("jump _start_");
+    ADD_INST1(OP_DEFVAR, common.arg1);
+    ADD_INST1(OP_DEFVAR, common.arg2);
+    ADD_INST1(OP_DEFVAR, common.output);
+
+    // temporaries of expressions are defined at the end of program
+    if (opt_level >= OPT_LEVEL_TAC) {
+        ADD_INST1(OP_JUMP, opd_label_name("_temps_"));
+    } else {
+        ADD_INST1(OP_JUMP, opd_label_name("_start_"));
+    }
 }
 
 // generate entry point - first call of function in main body of program
 void generate_entry()
 {
-    ADD_NEWLINE();
-    ADD_INST_N("label _start_");
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, opd_label_name("_start_"));
 }
 
 void generate_end()
 {
-    ADD_INST_N("jump _end_");
+    ADD_INST1(OP_JUMP, opd_label_name("_end_"));
+
+    if (opt_level >= OPT_LEVEL_TAC) {
+        // number of temporaries is known after all expressions were generated
+        ADD_INST1(OP_LABEL, opd_label_name("_temps_"));
+        for (int i = 0; i < expr.temps; i++) {
+            ADD_INST1(OP_DEFVAR, opd_var(FRAME_GF, generate_numbered("%t", i)));
+        }
+        ADD_INST1(OP_JUMP, opd_label_name("_start_"));
+    }
 }
 
 void generate_div_by_zero()
 {
-    ADD_INST_N("label _div_by_zero");
-    ADD_INST_N("exit int@9");
+    ADD_INST1(OP_LABEL, common.div_by_zero);
+    ADD_INST1(OP_EXIT, opd_int(9));
 }
 
 void generate_nil_with_operator()
 {
-    ADD_INST_N("label _nil_with_operator");
-    ADD_INST_N("exit int@8");
+    ADD_INST1(OP_LABEL, common.nil_with_operator);
+    ADD_INST1(OP_EXIT, opd_int(8));
 }
 
 void generate_write_nil()
 {
-    ADD_INST_N("label _write_nil");
-    ADD_INST_N("write string@nil");
-    ADD_INST_N("return");
+    ADD_INST1(OP_LABEL, opd_label_name("_write_nil"));
+    ADD_INST1(OP_WRITE, common.nil_type);
+    ADD_INST0(OP_RETURN);
 }
 
 void generate_exit()
 {
-    ADD_INST_N("label _end_");
+    ADD_INST1(OP_LABEL, opd_label_name("_end_"));
 }
 /*            END IFJcode21 ENTRY                  */
 
 // generate label from given string
-void generate_label(string_t label_name)
+void generate_label(atom_t *label_name)
 {
-    ADD_NEWLINE();
-    ADD_INST("label ");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+    ADD_BLANK();
+    ADD_INST1(OP_LABEL, opd_label(label_name));
 }
 
 /*           FUNCTION ENTRY               */
 void generate_retvals()
 {
-    // storage for converting number to string
-    string_t retval_num;
-    str_init(&retval_num);
-
     // item in global symtable corresponding to function
     struct global_item *func = global_find(global_tab, local_tab->key);
 
     // create local variables for return values in format LF@retval%N
     // N is the position of return value
     for (int retval = 0; retval < str_len(func->retvals); retval++) {
+        operand_t var = opd_var(FRAME_LF, generate_numbered("%retval", retval));
+
         // define variable
-        ADD_INST("defvar LF@%retval");
-        str_insert_int(&retval_num, retval);
-        strcat(INST, retval_num.str);
-        ADD_NEWLINE();
+        ADD_INST1(OP_DEFVAR, var);
 
         // initialize its value to nil
-        ADD_INST("move LF@%retval");
-        strcat(INST, retval_num.str);
-        strcat(INST, " nil@nil");
-        ADD_NEWLINE();
-
-        str_clear(&retval_num);
+        ADD_INST2(OP_MOVE, var, opd_nil());
     }
-
-    str_free(&retval_num);
 }
 
 void generate_parameters(parser_helper_t *p_helper)
 {
-    string_t num;
-    str_init(&num);
-
     int par_cnt = 0;
 
     // iterate through all identifiers in p_helper and create function parameters
     struct identifiers *tmp = p_helper->id_first;
     while (tmp != NULL) {
-        // variable definition
-        ADD_INST("defvar LF@");
         // create unique identificator name
-        generate_name(buffer, tmp->data->name);
-        ADD_NEWLINE();
+        operand_t var = opd_var(FRAME_LF, generate_name(tmp->data->name));
 
-        // assign value from function call
-        ADD_INST("move LF@");
-        generate_name(buffer, tmp->data->name);
-        strcat(INST, " LF@%");
+        // variable definition
+        ADD_INST1(OP_DEFVAR, var);
 
-        str_insert_int(&num, par_cnt++);
-        strcat(INST, num.str);
-        ADD_NEWLINE();
+        // assign value from function call
+        ADD_INST2(OP_MOVE, var, opd_var(FRAME_LF, generate_numbered("%", par_cnt++)));
 
-        str_clear(&num);
-        ADD_NEWLINE();
+        ADD_BLANK();
         tmp = tmp->next;
     }
-
-    str_free(&num);
 }
 
 void generate_function(parser_helper_t *p_helper)
 {
-    ADD_NEWLINE();
+    ADD_BLANK();
     generate_label(local_tab->key);
 
     // push previously set up temporary frame to frame stack
     // (TF@var becomes LF@var)
-    ADD_INST_N("pushframe");
+    ADD_INST0(OP_PUSHFRAME);
+
+    if (opt_level >= OPT_LEVEL_NIL) {
+        nil_reset();
+    }
 
     generate_retvals();
-    ADD_NEWLINE();
+    ADD_BLANK();
     generate_parameters(p_helper);
+
+    locals.length = 0;
+    locals.prologue = buffer->length;
+}
+
+void generate_function_locals()
+{
+    inst_t *defvar = ibuffer_insert(buffer, locals.prologue, locals.length);
+    if (defvar == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < locals.length; i++) {
+        defvar[i] = (inst_t){OP_DEFVAR, {opd_var(FRAME_LF, locals.name[i]), opd_none(), opd_none()}};
+    }
 }
 
 void generate_function_end()
 {
-    ADD_INST_N("popframe");
-    ADD_INST_N("return");
+    ADD_INST0(OP_POPFRAME);
+    ADD_INST0(OP_RETURN);
 }
 
-void generate_function_skip_jump(string_t name)
+// label for skipping function definition, function name with '_' prefix
+static operand_t generate_function_skip(atom_t *name)
 {
-    string_t s;
-    str_init(&s);
+    STR_BUFFERED(s);
 
     str_add_char(&s, '_');
-    str_insert(&s, name.str);
-
-    ADD_INST("jump ");
-    strcat(INST, s.str);
-    ADD_NEWLINE();
+    str_insert(&s, name->name.str);
 
+    operand_t label = opd_label(atom_intern(s.str, s.length));
     str_free(&s);
+    return label;
 }
 
-void generate_function_skip_label(string_t name)
+void generate_function_skip_jump(atom_t *name)
 {
-    string_t s;
-    str_init(&s);
-
-    str_add_char(&s, '_');
-    str_insert(&s, name.str);
-
-    ADD_INST("label ");
-    strcat(INST, s.str);
-    ADD_NEWLINE();
+    ADD_INST1(OP_JUMP, generate_function_skip(name));
+}
 
-    str_free(&s);
+void generate_function_skip_label(atom_t *name)
+{
+    ADD_INST1(OP_LABEL, generate_function_skip(name));
 }
 
 /*          END FUNCTION ENTRY             */
 
-// generate local identifers with mangled name
-void generate_identifier(ibuffer_t *buffer, string_t id_name)
+// frame variable of function for slot (local variables with same depth
+// of nested blocks), name is function$%slot
+static atom_t *generate_slot(size_t slot)
+{
+    STR_BUFFERED(generated);
+
+    str_insert(&generated, local_tab->key->name.str);
+    str_insert(&generated, "$%");
+    str_insert_int(&generated, slot);
+
+    atom_t *atom = atom_intern(generated.str, generated.length);
+    str_free(&generated);
+    return atom;
+}
+
+// generate local identifers with mangled name, variable is defined in
+// prologue of function and set to nil at declaration
+void generate_identifier(atom_t *id_name)
 {
-    ADD_INST("defvar LF@");
-    generate_name(buffer, id_name);
-    ADD_NEWLINE();
-    ADD_INST("move LF@");
-    generate_name(buffer, id_name);
-    strcat(INST, " nil@nil");
-    ADD_NEWLINE();
+    size_t slot = local_tab->slots++;
+    if (opt_level >= OPT_LEVEL_SLOTS) {
+        // variables of enclosing blocks take slots under it, the ones above
+        // were left by blocks which already ended
+        struct local_data *data = local_find_top(local_tab, id_name);
+        if (slot < locals.length) {
+            data->mangled = locals.name[slot];
+            ADD_INST2(OP_MOVE, opd_var(FRAME_LF, data->mangled), opd_nil());
+            return;
+        }
+        data->mangled = generate_slot(slot);
+    }
+
+    operand_t var = opd_var(FRAME_LF, generate_name(id_name));
+
+    if (locals.length == locals.size) {
+        // double the size, old array is returned to arena
+        size_t size = locals.size ? 2 * locals.size : LOCALS_SIZE;
+        atom_t **name = arena_alloc(&arena, size * sizeof(atom_t *));
+        if (name == NULL) {
+            return;
+        }
+        if (locals.name != NULL) {
+            memcpy(name, locals.name, locals.length * sizeof(atom_t *));
+            arena_free(&arena, locals.name, locals.size * sizeof(atom_t *));
+        }
+        locals.name = name;
+        locals.size = size;
+    }
+    locals.name[locals.length++] = var.val.atom;
+
+    ADD_INST2(OP_MOVE, var, opd_nil());
 }
 
 /*          FUNCTION CALL          */
 void generate_call_prep(parser_helper_t *p_helper)
 {
-    ADD_INST("createframe");
-    ADD_NEWLINE();
+    ADD_INST0(OP_CREATEFRAME);
 
-    string_t param_name;
-    str_init(&param_name);
     // generate generic names for function parameters
     for (int i = 0; i < str_len(p_helper->func->params); i++) {
-        ADD_INST("defvar TF@");
-        str_insert(&param_name, "%");
-        str_insert_int(&param_name, i);
-        strcat(INST, param_name.str);
-        ADD_NEWLINE();
-        str_clear(&param_name);
+        ADD_INST1(OP_DEFVAR, opd_var(FRAME_TF, generate_numbered("%", i)));
     }
-    str_free(&param_name);
 }
 
 void generate_call_params(token_t *token, parser_helper_t *p_helper)
 {
-    ADD_INST("move TF@");
-
-    string_t param_name;
-    str_init(&param_name);
-
-    str_insert(&param_name, "%");
-    str_insert_int(&param_name, p_helper->par_counter);
-    str_add_char(&param_name, ' ');
+    operand_t param = opd_var(FRAME_TF, generate_numbered("%", p_helper->par_counter));
     p_helper->par_counter++;
-    strcat(INST, param_name.str);
-
-    switch (token->type)
-    {
-    case TOK_STRING:
-        generate_string(token->attribute.s);
-        break;
-
-    case TOK_INT:
-        generate_int(token->attribute.number);
-        break;
-
-    case TOK_DECIMAL:
-        generate_decimal(token->attribute.decimal);
-        break;
-
-    case TOK_KEYWORD:
-        generate_nil();
-        break;
-
-    case TOK_ID:
-        strcat(INST, "LF@");
-        generate_name(buffer, token->attribute.s);
-        break;
 
-    default:
-        break;
+    if (token->type == TOK_ID) {
+        ADD_INST2(OP_MOVE, param, opd_var(FRAME_LF, generate_name(token->attribute.id)));
+    } else {
+        ADD_INST2(OP_MOVE, param, generate_constant(token));
     }
-
-    ADD_NEWLINE();
-    str_free(&param_name);
 }
 
 void generate_call(parser_helper_t *p_helper)
 {
-    ADD_INST("call ");
-    strcat(INST, p_helper->func->key.str);
-    ADD_NEWLINE();
+    ADD_INST1(OP_CALL, opd_label(p_helper->func->key));
 }
 
 void generate_return_value(int ret_counter)
 {
-    string_t retval_num;
-    str_init(&retval_num);
-
-    ADD_INST("pops LF@%retval");
-    str_insert_int(&retval_num, ret_counter);
-    strcat(INST, retval_num.str);
-    ADD_NEWLINE();
+    operand_t retval = opd_var(FRAME_LF, generate_numbered("%retval", ret_counter));
 
-    str_free(&retval_num);
+    if (opt_level >= OPT_LEVEL_TAC) {
+        expr_pop_into(retval);
+    } else {
+        ADD_INST1(OP_POPS, retval);
+    }
 }
 
 /*          END FUNCTION CALL             */
@@ -396,65 +545,96 @@ void generate_write(token_t *token)
     switch (token->type)
     {
     case TOK_STRING:
-        ADD_INST("write ");
-        generate_string(token->attribute.s);
-        break;
-
     case TOK_INT:
-        ADD_INST("write ");
-        generate_int(token->attribute.number);
-        break;
-
     case TOK_DECIMAL:
-        ADD_INST("write ");
-        generate_decimal(token->attribute.decimal);
+        ADD_INST1(OP_WRITE, generate_constant(token));
         break;
 
-    case TOK_ID:
-        // test if variable is nil
-        ADD_INST("type GF@bool ");
-        strcat(INST, "LF@");
-        generate_name(buffer, token->attribute.s);
-        ADD_NEWLINE();
-
-        string_t label_name;
-        str_init(&label_name);
+    case TOK_ID: {
+        operand_t var = opd_var(FRAME_LF, generate_name(token->attribute.id));
 
-        str_insert(&label_name, "_write_not_nil");
-        str_insert_int(&label_name, counter);
-
-        ADD_INST("jumpifneq ");
-        strcat(INST, label_name.str);
-        strcat(INST, " GF@bool string@nil");
-        ADD_NEWLINE();
+        if (opt_level >= OPT_LEVEL_NIL &&
+                nil_known(generate_variable(local_tab, token->attribute.id)).not_nil) {
+            ADD_INST1(OP_WRITE, var);
+            break;
+        }
 
-        ADD_INST_N("call _write_nil");
+        operand_t label = opd_label(generate_numbered("_write_not_nil", counter));
 
-        ADD_INST("label ");
-        strcat(INST, label_name.str);
-        ADD_NEWLINE();
+        // test if variable is nil
+        ADD_INST2(OP_TYPE, common.bool_var, var);
+        ADD_INST3(OP_JUMPIFNEQ, label, common.bool_var, common.nil_type);
 
-        ADD_INST("write ");
-        strcat(INST, "LF@");
-        generate_name(buffer, token->attribute.s);
+        ADD_INST1(OP_CALL, opd_label_name("_write_nil"));
 
-        str_free(&label_name);
+        ADD_INST1(OP_LABEL, label);
+        ADD_INST1(OP_WRITE, var);
 
         counter++;
+        break;
+    }
+
     default:
+        ADD_BLANK();
         break;
     }
+}
+
+static bool generate_is_var(operand_t *opd, operand_t *var)
+{
+    return opd->type == OPD_VAR && opd->frame == var->frame && opd->val.atom == var->val.atom;
+}
+
+/**
+ * @brief Declaration sets variable to nil, move of nil right before
+ *  expression which is assigned to the variable is left out if expression
+ *  doesn't read the variable (last instruction of buffer writes it)
+ */
+static void generate_dead_nil(operand_t var)
+{
+    if (expr.start == 0 || expr.start >= buffer->length) {
+        return;
+    }
 
-    ADD_NEWLINE();
+    inst_t *move = &buffer->inst[expr.start - 1];
+    if (move->op != OP_MOVE || move->arg[1].type != OPD_NIL || !generate_is_var(&move->arg[0], &var)) {
+        return;
+    }
+
+    for (size_t i = expr.start; i < buffer->length; i++) {
+        // first operand of last instruction is assigned variable
+        int first = i == buffer->length - 1 ? 1 : 0;
+        for (int j = first; j < 3; j++) {
+            if (generate_is_var(&buffer->inst[i].arg[j], &var)) {
+                return;
+            }
+        }
+    }
+
+    memmove(move, move + 1, (buffer->length - expr.start) * sizeof(inst_t));
+    buffer->length--;
+    expr.start--;
 }
 
 // single assign with expression
-void generate_assign(string_t name)
+void generate_assign(atom_t *name)
 {
-    // pop instruction to variable
-    ADD_INST("pops LF@");
-    generate_name(buffer, name);
-    ADD_NEWLINE();
+    operand_t var = opd_var(FRAME_LF, generate_name(name));
+
+    if (opt_level >= OPT_LEVEL_NIL) {
+        // variable keeps nil-ness of assigned result
+        known_t known = expr_known(1);
+        expr_pop_into(var);
+        nil_set(generate_variable(local_tab, name), known);
+    } else if (opt_level >= OPT_LEVEL_TAC) {
+        // result of expression is moved directly
+        expr_pop_into(var);
+    } else {
+        // pop instruction to variable
+        ADD_INST1(OP_POPS, var);
+    }
+
+    generate_dead_nil(var);
 }
 
 // assign function return values to identifiers
@@ -462,242 +642,437 @@ void generate_assign_function(parser_helper_t *p_helper)
 {
     // counter for retvals
     int counter = 0;
-    string_t counter_string;
-    str_init(&counter_string);
 
     // iterate through identifiers and move value from retval into ID
     struct identifiers *tmp = p_helper->id_first;
     while (tmp != NULL) {
-        ADD_INST("move LF@");
-        generate_name(buffer, tmp->data->name);
-        strcat(INST, " TF@%retval");
-        str_insert_int(&counter_string, counter);
+        ADD_INST2(OP_MOVE, opd_var(FRAME_LF, generate_name(tmp->data->name)),
+                opd_var(FRAME_TF, generate_numbered("%retval", counter)));
+        if (opt_level >= OPT_LEVEL_NIL) {
+            // function can return nil
+            nil_set(generate_variable(local_tab, tmp->data->name), KNOWN_NOTHING);
+        }
         counter++;
-        strcat(INST, counter_string.str);
-        ADD_NEWLINE();
         tmp = tmp->next;
-        str_clear(&counter_string);
     }
-
-    str_free(&counter_string);
 }
 
 /*          IF STATEMENT            */
-void generate_if_label(string_t *insert_to, char *label_or_jump)
-{
-    str_insert(insert_to, label_or_jump);
-    str_add_char(insert_to, '_');
-    str_insert(insert_to, local_tab->key.str);
-    str_add_char(insert_to, '_');
-    str_insert_int(insert_to, local_tab->depth);
-    str_add_char(insert_to, '_');
+static operand_t generate_if_label(char *suffix)
+{
+    STR_BUFFERED(label_name);
+
+    str_add_char(&label_name, '_');
+    str_insert(&label_name, local_tab->key->name.str);
+    str_add_char(&label_name, '_');
+    str_insert_int(&label_name, local_tab->depth);
+    str_add_char(&label_name, '_');
     // create counter based on previous if counter
-    str_insert_int(insert_to, local_tab->next->if_cnt);
-    str_add_char(insert_to, '_');
+    str_insert_int(&label_name, local_tab->next->if_cnt);
+    str_add_char(&label_name, '_');
     // determine, whether this part is before or after else
-    str_insert_int(insert_to, local_tab->next->after_else);
+    str_insert_int(&label_name, local_tab->next->after_else);
+    str_insert(&label_name, suffix);
+
+    operand_t label = opd_label(atom_intern(label_name.str, label_name.length));
+    str_free(&label_name);
+    return label;
 }
 
-void generate_else()
+static bool generate_is_bool(operand_t *opd)
 {
-    string_t label_name;
-    str_init(&label_name);
+    return opd->type == OPD_VAR && opd->val.atom == common.bool_var.val.atom;
+}
 
-    // if cond is true, skip else part
-    generate_if_label(&label_name, "jump ");
-    str_insert(&label_name, "_end");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
-    str_clear(&label_name);
+/**
+ * @brief Fuse relational operator at the end of condition with jump if
+ *  condition is false, result of == and ~= is not stored in GF@bool and
+ *  negation of <= and >= is left out
+ *
+ * @return true if jump was generated
+ */
+static bool generate_fused_jump(operand_t label)
+{
+    size_t count = buffer->length - expr.start;
+    if (count == 0) {
+        return false;
+    }
+    inst_t *inst = &buffer->inst[buffer->length - 1];
 
-    generate_if_label(&label_name, "label ");
-    str_insert(&label_name, "_else");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+    // three address code: eq GF@bool a b [not GF@bool GF@bool]
+    if (count >= 1 && inst[0].op == OP_EQ && generate_is_bool(&inst[0].arg[0])) {
+        inst[0] = (inst_t){OP_JUMPIFNEQ, {label, inst[0].arg[1], inst[0].arg[2]}};
+        return true;
+    }
+    if (count >= 2 && inst[0].op == OP_NOT && generate_is_bool(&inst[0].arg[0])) {
+        if (inst[-1].op == OP_EQ) {
+            inst[-1] = (inst_t){OP_JUMPIFEQ, {label, inst[-1].arg[1], inst[-1].arg[2]}};
+            buffer->length--;
+            return true;
+        }
+        if (inst[-1].op == OP_LT || inst[-1].op == OP_GT) {
+            buffer->length--;
+            ADD_INST3(OP_JUMPIFEQ, label, common.bool_var, opd_bool(true));
+            return true;
+        }
+        return false;
+    }
 
-    str_free(&label_name);
+    // stack code: eqs [nots] pops GF@bool
+    if (count < 2 || inst[0].op != OP_POPS || !generate_is_bool(&inst[0].arg[0])) {
+        return false;
+    }
+    if (inst[-1].op == OP_EQS) {
+        buffer->length -= 2;
+        ADD_INST1(OP_JUMPIFNEQS, label);
+        return true;
+    }
+    if (count >= 3 && inst[-1].op == OP_NOTS) {
+        if (inst[-2].op == OP_EQS) {
+            buffer->length -= 3;
+            ADD_INST1(OP_JUMPIFEQS, label);
+            return true;
+        }
+        if (inst[-2].op == OP_LTS || inst[-2].op == OP_GTS) {
+            inst[-1] = inst[0];
+            buffer->length--;
+            ADD_INST3(OP_JUMPIFEQ, label, common.bool_var, opd_bool(true));
+            return true;
+        }
+    }
+    return false;
 }
 
-void generate_if_else()
+// jump to label if condition in GF@bool is false
+static void generate_false_jump(operand_t label)
 {
-    string_t label_name;
-    str_init(&label_name);
+    if (opt_level >= OPT_LEVEL_BRANCH && generate_fused_jump(label)) {
+        return;
+    }
+    ADD_INST3(OP_JUMPIFNEQ, label, common.bool_var, opd_bool(true));
+}
 
-    generate_if_label(&label_name, "jumpifneq ");
-    str_insert(&label_name, "_else GF@bool bool@true");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+void generate_else()
+{
+    // if cond is true, skip else part
+    ADD_INST1(OP_JUMP, generate_if_label("_end"));
+    ADD_INST1(OP_LABEL, generate_if_label("_else"));
 
-    str_free(&label_name);
+    if (opt_level >= OPT_LEVEL_NIL) {
+        nil_else();
+    }
 }
 
-void generate_if_end()
+void generate_if_else()
 {
-    string_t label_name;
-    str_init(&label_name);
+    generate_false_jump(generate_if_label("_else"));
 
-    generate_if_label(&label_name, "label ");
-    str_insert(&label_name, "_end");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+    if (opt_level >= OPT_LEVEL_NIL) {
+        nil_if(local_tab->depth);
+    }
+}
 
-    str_free(&label_name);
+void generate_if_end()
+{
+    ADD_INST1(OP_LABEL, generate_if_label("_end"));
+
+    if (opt_level >= OPT_LEVEL_NIL) {
+        nil_if_end();
+    }
 }
 
 /*          END IF STATEMENT            */
 
 
 /*          WHILE STATEMENT             */
-void generate_while_label(string_t *insert_to, char *label_or_jump)
-{
-    str_insert(insert_to, label_or_jump);
-    str_add_char(insert_to, '_');
-    str_insert(insert_to, local_tab->key.str);
-    str_add_char(insert_to, '_');
-    str_insert_int(insert_to, local_tab->depth);
-    str_add_char(insert_to, '_');
-    str_insert_int(insert_to, local_tab->next->while_cnt);
-}
-
-void generate_while_start()
+static operand_t generate_while_label(char *suffix)
 {
-    string_t label_name;
-    str_init(&label_name);
+    STR_BUFFERED(label_name);
 
-    generate_while_label(&label_name, "label ");
-    str_insert(&label_name, "_start");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+    str_add_char(&label_name, '_');
+    str_insert(&label_name, local_tab->key->name.str);
+    str_add_char(&label_name, '_');
+    str_insert_int(&label_name, local_tab->depth);
+    str_add_char(&label_name, '_');
+    str_insert_int(&label_name, local_tab->next->while_cnt);
+    str_insert(&label_name, suffix);
 
+    operand_t label = opd_label(atom_intern(label_name.str, label_name.length));
     str_free(&label_name);
+    return label;
 }
 
-void generate_while_skip()
+// operator which can follow operand in expression
+static bool generate_is_operator(token_type_t type)
 {
-    string_t label_name;
-    str_init(&label_name);
+    return (type >= TOK_EQ && type <= TOK_GR_EQ) || (type >= TOK_LEN && type <= TOK_CONCAT);
+}
 
-    generate_while_label(&label_name, "jumpifneq ");
-    str_insert(&label_name, "_skip GF@bool bool@true");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+// what is known about right side of assignment starting at token i, only
+// its first tokens are checked (constant, string length or operator applied
+// to variable are not nil, integer constant alone assigned to integer
+// variable is known exactly)
+static known_t generate_side_known(size_t i, struct local_data *var)
+{
+    bool alone = i + 1 >= tokens.count || !generate_is_operator(tokens.type[i + 1]);
 
-    str_free(&label_name);
+    switch (tokens.type[i])
+    {
+    case TOK_INT:
+        if (alone && var != NULL && var->type == INT_T) {
+            int64_t value = tokens.value[tokens.attr[i]].number;
+            return (known_t){true, value, value};
+        }
+        return (known_t){true, INT64_MIN, INT64_MAX};
+
+    case TOK_DECIMAL:
+    case TOK_STRING:
+    case TOK_LEN:
+        return (known_t){true, INT64_MIN, INT64_MAX};
+
+    case TOK_ID:
+        return alone ? KNOWN_NOTHING : (known_t){true, INT64_MIN, INT64_MAX};
+
+    default:
+        return KNOWN_NOTHING;
+    }
 }
 
-void generate_while_end()
+/**
+ * @brief Body of loop is scanned before it's generated, state of variable
+ *  assigned in body is joined with states of all its assignments already
+ *  at the start of loop
+ */
+static void generate_while_nilness()
 {
-    string_t label_name;
-    str_init(&label_name);
+    unsigned int depth = 0;
+
+    // current token is while, scan ends at its end
+    for (size_t i = tokens.pos + 1; i < tokens.count; i++) {
+        if (tokens.type[i] == TOK_KEYWORD) {
+            keyword_t kw = tokens.attr[i];
+            if (kw == KW_IF || kw == KW_WHILE) {
+                depth++;
+            } else if (kw == KW_END && depth-- == 0) {
+                break;
+            }
+            continue;
+        }
 
-    generate_while_label(&label_name, "jump ");
-    str_insert(&label_name, "_start");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+        // declaration (type before =) assigns to variable of loop
+        if (tokens.type[i] != TOK_ASSIGN || tokens.type[i - 1] != TOK_ID) {
+            continue;
+        }
 
-    str_clear(&label_name);
+        size_t first = i - 1;
+        while (first >= 2 && tokens.type[first - 1] == TOK_COMMA &&
+                tokens.type[first - 2] == TOK_ID) {
+            first -= 2;
+        }
 
-    generate_while_label(&label_name, "label ");
-    str_insert(&label_name, "_skip");
-    strcat(INST, label_name.str);
-    ADD_NEWLINE();
+        // values of multiple assignment are not checked
+        bool single = first == i - 1 && i + 1 < tokens.count;
 
-    str_free(&label_name);
+        for (size_t j = first; j < i; j += 2) {
+            struct local_data *var = local_find(local_tab, tokens.value[tokens.attr[j]].id);
+            known_t side = single ? generate_side_known(i + 1, var) : KNOWN_NOTHING;
+            nil_set(var, nil_join(nil_known(var), side));
+        }
+    }
 }
-/*          END WHILE STATEMENT             */
-
 
-/*          EXPRESSION              */
-void generate_expr_start()
+void generate_while_start()
 {
-    ADD_INST_N("#EXPR START");
+    // label is inserted here by generate_while_skip() only if loop is not
+    // rotated, until then cond_start holds its position
+    local_tab->cond_start = buffer->length;
+
+    if (opt_level >= OPT_LEVEL_NIL) {
+        generate_while_nilness();
+        nil_loop(local_tab->depth);
+    }
 }
 
-void generate_expr_end()
+// negation of conditional jump, OP_BLANK if instruction is not one
+static opcode_t generate_negated_jump(opcode_t op)
 {
-    ADD_INST_N("#EXPR END");
+    switch (op) {
+        case OP_JUMPIFEQ:
+            return OP_JUMPIFNEQ;
+        case OP_JUMPIFNEQ:
+            return OP_JUMPIFEQ;
+        case OP_JUMPIFEQS:
+            return OP_JUMPIFNEQS;
+        case OP_JUMPIFNEQS:
+            return OP_JUMPIFEQS;
+        default:
+            return OP_BLANK;
+    }
 }
 
-void generate_strlen()
+/**
+ * @brief Condition can be copied to the end of loop, it must not define
+ *  labels (conversion of int to number) and it must end with conditional
+ *  jump which can be negated
+ */
+static bool generate_rotatable(size_t start, size_t end)
 {
-    // pop operand into GF@output
-    ADD_INST_N("pops GF@arg1");
-    ADD_INST_N("strlen GF@output GF@arg1");
-    ADD_INST_N("pushs GF@output");
+    if (end <= start || generate_negated_jump(buffer->inst[end - 1].op) == OP_BLANK) {
+        return false;
+    }
+    for (size_t i = start; i < end; i++) {
+        if (buffer->inst[i].op == OP_LABEL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void generate_while_skip()
+{
+    generate_false_jump(generate_while_label("_skip"));
+
+    // loop is rotated: condition, jump to skip, body, condition, jump to body
+    if (opt_level >= OPT_LEVEL_ROTATE && generate_rotatable(expr.start, buffer->length)) {
+        local_tab->cond_start = expr.start;
+        local_tab->cond_end = buffer->length;
+        ADD_INST1(OP_LABEL, generate_while_label("_body"));
+        return;
+    }
+
+    // condition is tested at the start of every iteration
+    inst_t *label = ibuffer_insert(buffer, local_tab->cond_start, 1);
+    if (label != NULL) {
+        *label = (inst_t){OP_LABEL, {generate_while_label("_start"), opd_none(), opd_none()}};
+    }
+}
+
+void generate_while_end()
+{
+    if (local_tab->cond_end != 0) {
+        // condition is still in buffer, loop is printed after its end
+        for (size_t i = local_tab->cond_start; i < local_tab->cond_end - 1; i++) {
+            inst_t inst = buffer->inst[i];
+            ibuffer_add(buffer, inst.op, inst.arg[0], inst.arg[1], inst.arg[2]);
+        }
+
+        // jump to skip label is turned to jump to body if condition is true
+        inst_t jump = buffer->inst[local_tab->cond_end - 1];
+        ibuffer_add(buffer, generate_negated_jump(jump.op), generate_while_label("_body"),
+                jump.arg[1], jump.arg[2]);
+    } else {
+        ADD_INST1(OP_JUMP, generate_while_label("_start"));
+    }
+    ADD_INST1(OP_LABEL, generate_while_label("_skip"));
+
+    if (opt_level >= OPT_LEVEL_NIL) {
+        nil_loop_end();
+    }
+}
+/*          END WHILE STATEMENT             */
+
+
+/*          EXPRESSION              */
+void generate_expr_init()
+{
+    // operands left by previous expression (e.g. condition without
+    // relational operator) are forgotten
+    expr.cached = 0;
+    expr.depth = 0;
+    expr.start = buffer->length;
+}
+
+void generate_expr_start()
+{
+    ADD_INST1(OP_COMMENT, opd_text("#EXPR START"));
+}
+
+void generate_expr_end()
+{
+    ADD_INST1(OP_COMMENT, opd_text("#EXPR END"));
+}
+
+void generate_strlen()
+{
+    // pop operand into GF@output
+    ADD_INST1(OP_POPS, common.arg1);
+    ADD_INST2(OP_STRLEN, common.output, common.arg1);
+    ADD_INST1(OP_PUSHS, common.output);
 }
 
 void generate_concat()
 {
-    // pop operands into GF@arg1 GF@arg2
-    ADD_INST_N("pops GF@arg2");
-    ADD_INST_N("pops GF@arg1");
-    ADD_INST_N("concat GF@output GF@arg1 GF@arg2");
-    ADD_INST_N("pushs GF@output");
+    // pop operands into GF@common.arg1 GF@common.arg2
+    ADD_INST1(OP_POPS, common.arg2);
+    ADD_INST1(OP_POPS, common.arg1);
+    ADD_INST3(OP_CONCAT, common.output, common.arg1, common.arg2);
+    ADD_INST1(OP_PUSHS, common.output);
 }
+
+// compare with equality, result of (op || ==) is on stack
+static void generate_compare_or_equal(opcode_t op)
+{
+    // store variables
+    ADD_INST1(OP_POPS, common.arg2);
+    ADD_INST1(OP_POPS, common.arg1);
+
+    // compare < or > only
+    ADD_INST1(OP_PUSHS, common.arg1);
+    ADD_INST1(OP_PUSHS, common.arg2);
+    ADD_INST0(op);
+
+    // compare ==
+    ADD_INST1(OP_PUSHS, common.arg1);
+    ADD_INST1(OP_PUSHS, common.arg2);
+    ADD_INST0(OP_EQS);
+
+    // compare <= or >=
+    ADD_INST0(OP_ORS);
+}
+
 void generate_push_compare(prec_table_term_t op)
 {
     switch (op)
     {
     case EQ:
-        ADD_INST_N("eqs");
+        ADD_INST0(OP_EQS);
         break;
 
     case NOT_EQ:
-        ADD_INST_N("eqs");
-        ADD_INST_N("nots");
+        ADD_INST0(OP_EQS);
+        ADD_INST0(OP_NOTS);
         break;
 
     case LESS:
-        ADD_INST_N("lts");
+        ADD_INST0(OP_LTS);
         break;
 
     case LESS_EQ:
-        // store variables
-        ADD_INST_N("pops GF@arg2");
-        ADD_INST_N("pops GF@arg1");
-
-        // compare < only
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("pushs GF@arg2");
-        ADD_INST_N("lts");
-
-        // compare ==
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("pushs GF@arg2");
-        ADD_INST_N("eqs");
-
-        // compare <=
-        ADD_INST_N("ors");
+        generate_compare_or_equal(OP_LTS);
         break;
 
     case GREAT:
-        ADD_INST_N("gts");
+        ADD_INST0(OP_GTS);
         break;
 
     case GREAT_EQ:
-        // store variables
-        ADD_INST_N("pops GF@arg2");
-        ADD_INST_N("pops GF@arg1");
-
-        // compare > only
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("pushs GF@arg2");
-        ADD_INST_N("gts");
-
-        // compare ==
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("pushs GF@arg2");
-        ADD_INST_N("eqs");
-
-        // compare >=
-        ADD_INST_N("ors");
+        generate_compare_or_equal(OP_GTS);
         break;
 
     default:
         break;
     }
 
-    ADD_INST_N("pops GF@bool");
+    ADD_INST1(OP_POPS, common.bool_var);
+}
+
+// a <= b as not (a > b) and a >= b as not (a < b), only for operands which
+// are always ordered (integers and strings, number can be NaN)
+static void generate_push_negated(prec_table_term_t op)
+{
+    ADD_INST0(op == LESS_EQ ? OP_GTS : OP_LTS);
+    ADD_INST0(OP_NOTS);
+    ADD_INST1(OP_POPS, common.bool_var);
 }
 
 void generate_push_arithmetic(prec_table_term_t op)
@@ -705,31 +1080,31 @@ void generate_push_arithmetic(prec_table_term_t op)
     switch (op)
     {
     case MINUS:
-        ADD_INST_N("subs");
+        ADD_INST0(OP_SUBS);
         break;
 
     case PLUS:
-        ADD_INST_N("adds");
+        ADD_INST0(OP_ADDS);
         break;
 
     case MUL:
-        ADD_INST_N("muls");
+        ADD_INST0(OP_MULS);
         break;
 
     case DIV:
         // division by 0 check
-        ADD_INST_N("pops GF@arg1");
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("jumpifeq _div_by_zero GF@arg1 float@0x0p+0");
-        ADD_INST_N("divs");
+        ADD_INST1(OP_POPS, common.arg1);
+        ADD_INST1(OP_PUSHS, common.arg1);
+        ADD_INST3(OP_JUMPIFEQ, common.div_by_zero, common.arg1, opd_float(0.0));
+        ADD_INST0(OP_DIVS);
         break;
 
     case DIV_INT:
         // division by 0 check
-        ADD_INST_N("pops GF@arg1");
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("jumpifeq _div_by_zero GF@arg1 int@0");
-        ADD_INST_N("idivs");
+        ADD_INST1(OP_POPS, common.arg1);
+        ADD_INST1(OP_PUSHS, common.arg1);
+        ADD_INST3(OP_JUMPIFEQ, common.div_by_zero, common.arg1, opd_int(0));
+        ADD_INST0(OP_IDIVS);
         break;
 
     default:
@@ -737,57 +1112,169 @@ void generate_push_arithmetic(prec_table_term_t op)
     }
 }
 
+// jump to error if operand is nil
+static void generate_nil_jump(operand_t var)
+{
+    ADD_INST2(OP_TYPE, common.bool_var, var);
+    ADD_INST3(OP_JUMPIFEQ, common.nil_with_operator, common.bool_var, common.nil_type);
+}
+
 void generate_check_nil()
 {
-    ADD_INST_N("pops GF@arg1");
-    ADD_INST_N("pops GF@arg2");
-    ADD_INST_N("pushs GF@arg2");
-    ADD_INST_N("pushs GF@arg1");
-    ADD_INST_N("type GF@bool GF@arg1");
-    ADD_INST_N("jumpifeq _nil_with_operator GF@bool string@nil");
-    ADD_INST_N("type GF@bool GF@arg2");
-    ADD_INST_N("jumpifeq _nil_with_operator GF@bool string@nil");
+    ADD_INST1(OP_POPS, common.arg1);
+    ADD_INST1(OP_POPS, common.arg2);
+    ADD_INST1(OP_PUSHS, common.arg2);
+    ADD_INST1(OP_PUSHS, common.arg1);
+    generate_nil_jump(common.arg1);
+    generate_nil_jump(common.arg2);
+}
+
+// with three address code, constants other than nil need no check
+static void generate_tac_check_nil(operand_t opd)
+{
+    if (opd.type == OPD_VAR || opd.type == OPD_NIL) {
+        generate_nil_jump(opd);
+    }
+}
+
+// check that top count operands are not nil (top is checked first), operands
+// known by nil-ness analysis are skipped
+static void generate_tac_check_operands(int count)
+{
+    expr_fetch(count);
+    for (int i = 1; i <= count && i <= expr.cached; i++) {
+        if (opt_level >= OPT_LEVEL_NIL && expr.known[expr.cached - i].not_nil) {
+            continue;
+        }
+        generate_tac_check_nil(expr.item[expr.cached - i]);
+    }
+}
+
+// x + y, false if it overflows
+static bool range_add(int64_t x, int64_t y, int64_t *result)
+{
+    if ((y > 0 && x > INT64_MAX - y) || (y < 0 && x < INT64_MIN - y)) {
+        return false;
+    }
+    *result = x + y;
+    return true;
+}
+
+// x - y, false if it overflows
+static bool range_sub(int64_t x, int64_t y, int64_t *result)
+{
+    if ((y < 0 && x > INT64_MAX + y) || (y > 0 && x < INT64_MIN + y)) {
+        return false;
+    }
+    *result = x - y;
+    return true;
+}
+
+// x * y, false if it overflows
+static bool range_mul(int64_t x, int64_t y, int64_t *result)
+{
+    bool overflow;
+    if (x > 0) {
+        overflow = y > 0 ? x > INT64_MAX / y : y < INT64_MIN / x;
+    } else {
+        overflow = y > 0 ? x < INT64_MIN / y : x != 0 && y < INT64_MAX / x;
+    }
+    if (overflow) {
+        return false;
+    }
+    *result = x * y;
+    return true;
+}
+
+/**
+ * @brief Range of result of add, sub or mul is computed from corners of
+ *  ranges of operands, result can be anything if some corner overflows
+ *  (integers wrap around), other operators are not tracked
+ */
+static known_t generate_known_result(opcode_t op, known_t a, known_t b)
+{
+    known_t result = {true, INT64_MIN, INT64_MAX};
+    int64_t xs[] = {a.min, a.min, a.max, a.max};
+    int64_t ys[] = {b.min, b.max, b.min, b.max};
+    int64_t corner[4];
+
+    for (int i = 0; i < 4; i++) {
+        bool ok;
+        switch (op) {
+            case OP_ADD:
+                ok = range_add(xs[i], ys[i], &corner[i]);
+                break;
+            case OP_SUB:
+                ok = range_sub(xs[i], ys[i], &corner[i]);
+                break;
+            case OP_MUL:
+                ok = range_mul(xs[i], ys[i], &corner[i]);
+                break;
+            default:
+                ok = false;
+                break;
+        }
+        if (!ok) {
+            return result;
+        }
+    }
+
+    result.min = result.max = corner[0];
+    for (int i = 1; i < 4; i++) {
+        result.min = corner[i] < result.min ? corner[i] : result.min;
+        result.max = corner[i] > result.max ? corner[i] : result.max;
+    }
+    return result;
+}
+
+// a op b, result is stored in temporary which replaces a on stack
+static void generate_tac_binary(opcode_t op)
+{
+    known_t known = generate_known_result(op, expr_known(2), expr_known(1));
+    operand_t b = expr_pop();
+    operand_t a = expr_pop();
+    operand_t result = expr_temp(expr.depth);
+
+    ADD_INST3(op, result, a, b);
+    expr_push(result, known);
 }
 
-void generate_push_operator(prec_table_term_t op)
+// a op b, result is stored in GF@bool like with stack code, <= and >= of
+// ordered operands (not number) negate strict comparison
+static void generate_tac_compare(prec_table_term_t op, bool ordered)
 {
+    operand_t b = expr_pop();
+    operand_t a = expr_pop();
+
     switch (op)
     {
-    case MINUS:
-    case PLUS:
-    case MUL:
-    case DIV:
-    case DIV_INT:
-        // check both operands are not nil
-        generate_check_nil();
-        generate_push_arithmetic(op);
+    case EQ:
+        ADD_INST3(OP_EQ, common.bool_var, a, b);
         break;
 
-    case EQ:
     case NOT_EQ:
-        generate_push_compare(op);
+        ADD_INST3(OP_EQ, common.bool_var, a, b);
+        ADD_INST2(OP_NOT, common.bool_var, common.bool_var);
         break;
 
     case LESS:
-    case LESS_EQ:
-    case GREAT:
-    case GREAT_EQ:
-        // check both operands are not nil
-        generate_check_nil();
-        generate_push_compare(op);
+        ADD_INST3(OP_LT, common.bool_var, a, b);
         break;
 
-    case STR_LEN:
-        ADD_INST_N("pops GF@arg1");
-        ADD_INST_N("pushs GF@arg1");
-        ADD_INST_N("type GF@bool GF@arg1");
-        ADD_INST_N("jumpifeq _nil_with_operator GF@bool string@nil");
-        generate_strlen();
+    case GREAT:
+        ADD_INST3(OP_GT, common.bool_var, a, b);
         break;
 
-    case CONCAT:
-        generate_check_nil();
-        generate_concat();
+    case LESS_EQ:
+    case GREAT_EQ:
+        if (ordered) {
+            ADD_INST3(op == LESS_EQ ? OP_GT : OP_LT, common.bool_var, a, b);
+            ADD_INST2(OP_NOT, common.bool_var, common.bool_var);
+            break;
+        }
+        ADD_INST3(op == LESS_EQ ? OP_LT : OP_GT, common.output, a, b);
+        ADD_INST3(OP_EQ, common.bool_var, a, b);
+        ADD_INST3(OP_OR, common.bool_var, common.bool_var, common.output);
         break;
 
     default:
@@ -795,109 +1282,345 @@ void generate_push_operator(prec_table_term_t op)
     }
 }
 
-void generate_name_previous_depth(ibuffer_t *buffer, string_t name)
+// compare constants of the same type, false if they can't be compared
+static bool generate_fold_compare(operand_t *a, operand_t *b, int *result)
 {
-    local_symtab_t *symtab = local_symtab_find(local_tab->next, name);
-    if (symtab == NULL)
-        return;
+    if (a->type != b->type) {
+        return false;
+    }
 
-    string_t generated;
-    str_init(&generated);
+    switch (a->type)
+    {
+    case OPD_INT:
+        *result = (a->val.i > b->val.i) - (a->val.i < b->val.i);
+        return true;
 
-    str_insert(&generated, local_tab->key.str);
-    str_insert(&generated, "$");
-    str_insert_int(&generated, symtab->depth);
+    case OPD_FLOAT:
+        *result = (a->val.d > b->val.d) - (a->val.d < b->val.d);
+        return true;
 
-    if (symtab->depth != 0) {
-        str_insert(&generated, "$");
-        str_insert_int(&generated, symtab->next->if_cnt);
-        str_insert(&generated, "$");
-        str_insert_int(&generated, symtab->next->while_cnt);
+    case OPD_STRING: {
+        string_t *x = &a->val.atom->name;
+        string_t *y = &b->val.atom->name;
+
+        // interpreter compares C strings, they would end at \0
+        if (memchr(x->str, '\0', x->length) || memchr(y->str, '\0', y->length)) {
+            return false;
+        }
+
+        int cmp = memcmp(x->str, y->str, x->length < y->length ? x->length : y->length);
+        if (cmp == 0) {
+            cmp = (x->length > y->length) - (x->length < y->length);
+        }
+        *result = (cmp > 0) - (cmp < 0);
+        return true;
     }
 
-    str_insert(&generated, "$");
-    str_insert(&generated, name.str);
+    default:
+        return false;
+    }
+}
 
-    strcat(INST, generated.str);
-    str_free(&generated);
+/**
+ * @brief Evaluate operator with constant operands at compile time, operations
+ *  which would fail at runtime (nil, mixed types, division by zero) are kept
+ *
+ * @return true if operator was folded, false if it has to be generated
+ */
+static bool generate_tac_fold(prec_table_term_t op)
+{
+    int count = op == STR_LEN ? 1 : 2;
+
+    expr_fetch(count);
+    if (expr.cached < count) {
+        return false;
+    }
+
+    operand_t *b = &expr.item[expr.cached - 1];
+    if (op == STR_LEN) {
+        if (b->type != OPD_STRING) {
+            return false;
+        }
+        *b = opd_int(b->val.atom->name.length);
+        expr.known[expr.cached - 1] = expr_constant_known(*b);
+        return true;
+    }
+
+    operand_t *a = &expr.item[expr.cached - 2];
+    if (a->type == OPD_VAR || b->type == OPD_VAR) {
+        return false;
+    }
+
+    bool ints = a->type == OPD_INT && b->type == OPD_INT;
+    bool floats = a->type == OPD_FLOAT && b->type == OPD_FLOAT;
+    operand_t result;
+    int cmp;
+
+    switch (op)
+    {
+    case PLUS:
+    case MINUS:
+    case MUL:
+        if (ints) {
+            // integers wrap around like in interpreter
+            uint64_t x = a->val.i;
+            uint64_t y = b->val.i;
+            result = opd_int((int64_t)(op == PLUS ? x + y : op == MINUS ? x - y : x * y));
+        } else if (floats) {
+            double x = a->val.d;
+            double y = b->val.d;
+            result = opd_float(op == PLUS ? x + y : op == MINUS ? x - y : x * y);
+        } else {
+            return false;
+        }
+        break;
+
+    case DIV:
+        if (!floats || b->val.d == 0.0) {
+            return false;
+        }
+        result = opd_float(a->val.d / b->val.d);
+        break;
+
+    case DIV_INT: {
+        if (!ints || b->val.i == 0 || (a->val.i == INT64_MIN && b->val.i == -1)) {
+            return false;
+        }
+        // rounded towards negative infinity
+        int64_t q = a->val.i / b->val.i;
+        if (a->val.i % b->val.i != 0 && (a->val.i < 0) != (b->val.i < 0)) {
+            q--;
+        }
+        result = opd_int(q);
+        break;
+    }
+
+    case CONCAT: {
+        if (a->type != OPD_STRING || b->type != OPD_STRING) {
+            return false;
+        }
+        STR_BUFFERED(joined);
+        str_insert_n(&joined, a->val.atom->name.str, a->val.atom->name.length);
+        str_insert_n(&joined, b->val.atom->name.str, b->val.atom->name.length);
+        result = opd_string(atom_intern(joined.str, joined.length));
+        str_free(&joined);
+        break;
+    }
+
+    case EQ:
+    case NOT_EQ:
+        if (a->type == OPD_NIL || b->type == OPD_NIL) {
+            cmp = a->type != b->type;
+        } else if (!generate_fold_compare(a, b, &cmp)) {
+            return false;
+        }
+        ADD_INST2(OP_MOVE, common.bool_var, opd_bool(op == EQ ? cmp == 0 : cmp != 0));
+        expr_pop();
+        expr_pop();
+        return true;
+
+    case LESS:
+    case LESS_EQ:
+    case GREAT:
+    case GREAT_EQ: {
+        if (!generate_fold_compare(a, b, &cmp)) {
+            return false;
+        }
+        bool value = op == LESS ? cmp < 0 : op == LESS_EQ ? cmp <= 0 :
+                op == GREAT ? cmp > 0 : cmp >= 0;
+        ADD_INST2(OP_MOVE, common.bool_var, opd_bool(value));
+        expr_pop();
+        expr_pop();
+        return true;
+    }
+
+    default:
+        return false;
+    }
+
+    // overflow to inf can't be written as IFJcode21 constant
+    if (result.type == OPD_FLOAT && !isfinite(result.val.d)) {
+        return false;
+    }
+
+    expr_pop();
+    *a = result;
+    expr.known[expr.cached - 1] = expr_constant_known(result);
+    return true;
 }
 
-void generate_push_operand(token_t *token)
+// three address code version of generate_push_operator()
+static void generate_tac_operator(prec_table_term_t op, bool ordered)
 {
-    ADD_INST("pushs ");
+    // operators with constant operands are evaluated by compiler
+    if (generate_tac_fold(op)) {
+        return;
+    }
 
-    switch (token->type)
+    switch (op)
     {
-    case TOK_STRING:
-        generate_string(token->attribute.s);
+    case MINUS:
+        generate_tac_check_operands(2);
+        generate_tac_binary(OP_SUB);
         break;
 
-    case TOK_DECIMAL:
-        generate_decimal(token->attribute.decimal);
+    case PLUS:
+        generate_tac_check_operands(2);
+        generate_tac_binary(OP_ADD);
         break;
 
-    case TOK_INT:
-        generate_int(token->attribute.number);
+    case MUL:
+        generate_tac_check_operands(2);
+        generate_tac_binary(OP_MUL);
         break;
 
-    case TOK_ID:
-        strcat(INST, "LF@");
-        if (str_getlast(p_helper->status) == 'i') {
-            if (p_helper->id_first != NULL) {
-                generate_name_previous_depth(buffer, token->attribute.s);
-            } else {
-                generate_name(buffer, token->attribute.s);
-            }
-        } else {
-            generate_name(buffer, token->attribute.s);
+    case DIV:
+    case DIV_INT: {
+        generate_tac_check_operands(2);
+        // division by 0 check, divisor known to be nonzero needs none (range
+        // is tracked only for integers, float can be only nonzero constant)
+        operand_t *divisor = expr_top();
+        known_t known = expr_known(1);
+        bool nonzero = opt_level >= OPT_LEVEL_RANGE && (op == DIV ?
+                divisor != NULL && divisor->type == OPD_FLOAT && divisor->val.d != 0.0 :
+                known.min > 0 || known.max < 0);
+        if (divisor != NULL && !nonzero) {
+            ADD_INST3(OP_JUMPIFEQ, common.div_by_zero, *divisor,
+                    op == DIV ? opd_float(0.0) : opd_int(0));
         }
+        generate_tac_binary(op == DIV ? OP_DIV : OP_IDIV);
         break;
+    }
 
-    case TOK_KEYWORD:
-        strcat(INST, "nil@nil");
+    case EQ:
+    case NOT_EQ:
+        generate_tac_compare(op, ordered);
         break;
 
-    default:
+    case LESS:
+    case LESS_EQ:
+    case GREAT:
+    case GREAT_EQ:
+        generate_tac_check_operands(2);
+        generate_tac_compare(op, ordered);
+        break;
+
+    case STR_LEN: {
+        generate_tac_check_operands(1);
+        operand_t a = expr_pop();
+        operand_t result = expr_temp(expr.depth);
+        ADD_INST2(OP_STRLEN, result, a);
+        expr_push(result, (known_t){true, 0, INT64_MAX});
         break;
     }
 
-    ADD_NEWLINE();
+    case CONCAT:
+        generate_tac_check_operands(2);
+        generate_tac_binary(OP_CONCAT);
+        break;
+
+    default:
+        break;
+    }
 }
-/*          END EXPRESSION          */
 
-void generate_num_conversion(unsigned index)
+void generate_push_operator(prec_table_term_t op, int type)
 {
-    static int counter = 0;
+    // operands are integers or strings (others convert type to T_NUM/T_NIL)
+    bool ordered = opt_level >= OPT_LEVEL_COMPARE && (type == T_INT || type == T_STR);
 
-    string_t s;
-    str_init(&s);
+    if (opt_level >= OPT_LEVEL_TAC) {
+        generate_tac_operator(op, ordered);
+        return;
+    }
 
-    str_insert_int(&s, counter);
-    ADD_INST("jumpifeq _conv_nil");
-    strcat(INST, s.str);
-    strcat(INST, " TF@%");
-    str_clear(&s);
-    str_insert_int(&s, index);
-    strcat(INST, s.str);
-    strcat(INST, " nil@nil");
-    ADD_NEWLINE();
+    switch (op)
+    {
+    case MINUS:
+    case PLUS:
+    case MUL:
+    case DIV:
+    case DIV_INT:
+        // check both operands are not nil
+        generate_check_nil();
+        generate_push_arithmetic(op);
+        break;
 
+    case EQ:
+    case NOT_EQ:
+        generate_push_compare(op);
+        break;
 
-    ADD_INST("int2float ");
-    strcat(INST, "TF@%");
-    strcat(INST, s.str);
+    case LESS:
+    case LESS_EQ:
+    case GREAT:
+    case GREAT_EQ:
+        // check both operands are not nil
+        generate_check_nil();
+        if (ordered && (op == LESS_EQ || op == GREAT_EQ)) {
+            generate_push_negated(op);
+        } else {
+            generate_push_compare(op);
+        }
+        break;
 
-    strcat(INST, " TF@%");
-    strcat(INST, s.str);
-    ADD_NEWLINE();
+    case STR_LEN:
+        ADD_INST1(OP_POPS, common.arg1);
+        ADD_INST1(OP_PUSHS, common.arg1);
+        generate_nil_jump(common.arg1);
+        generate_strlen();
+        break;
 
-    str_clear(&s);
-    str_insert_int(&s, counter);
-    ADD_INST("label _conv_nil");
-    strcat(INST, s.str);
-    ADD_NEWLINE();
+    case CONCAT:
+        generate_check_nil();
+        generate_concat();
+        break;
 
-    str_free(&s);
+    default:
+        break;
+    }
+}
+
+void generate_push_operand(token_t *token)
+{
+    if (token->type != TOK_ID) {
+        if (opt_level >= OPT_LEVEL_TAC) {
+            operand_t constant = generate_constant(token);
+            expr_push(constant, expr_constant_known(constant));
+        } else {
+            ADD_INST1(OP_PUSHS, generate_constant(token));
+        }
+        return;
+    }
+
+    atom_t *name;
+    local_symtab_t *symtab = local_tab;
+    if (str_getlast(p_helper->status) == 'i' && p_helper->id_first != NULL) {
+        name = generate_name_previous_depth(token->attribute.id);
+        symtab = local_tab->next;
+    } else {
+        name = generate_name(token->attribute.id);
+    }
+
+    if (opt_level >= OPT_LEVEL_TAC) {
+        expr_push(opd_var(FRAME_LF, name),
+                nil_known(generate_variable(symtab, token->attribute.id)));
+    } else {
+        ADD_INST1(OP_PUSHS, opd_var(FRAME_LF, name));
+    }
+}
+/*          END EXPRESSION          */
+
+void generate_num_conversion(unsigned index)
+{
+    static int counter = 0;
+
+    operand_t param = opd_var(FRAME_TF, generate_numbered("%", index));
+    operand_t label = opd_label(generate_numbered("_conv_nil", counter));
+
+    ADD_INST3(OP_JUMPIFEQ, label, param, opd_nil());
+    ADD_INST2(OP_INT2FLOAT, param, param);
+    ADD_INST1(OP_LABEL, label);
 
     counter++;
 }
@@ -906,25 +1629,48 @@ void generate_int_to_num()
 {
     static int counter = 0;
 
-    string_t s;
-    str_init(&s);
-    str_insert_int(&s, counter);
+    operand_t label = opd_label(generate_numbered("_itn_nil", counter));
 
-    ADD_INST_N("pops GF@bool");
-    ADD_INST_N("pushs GF@bool");
+    operand_t *top = opt_level >= OPT_LEVEL_TAC ? expr_top() : NULL;
+    if (top != NULL) {
+        if (top->type == OPD_NIL) {
+            return;
+        }
 
-    ADD_INST("jumpifeq _itn_nil");
-    strcat(INST, s.str);
-    strcat(INST, " GF@bool nil@nil");
-    ADD_NEWLINE();
+        // float can be rounded, range of integer is not valid for it
+        known_t *known = &expr.known[expr.cached - 1];
+        *known = (known_t){known->not_nil, INT64_MIN, INT64_MAX};
 
-    ADD_INST_N("int2floats");
+        if (top->type == OPD_INT) {
+            // constant is converted by compiler
+            *top = opd_float((double)top->val.i);
+            return;
+        }
 
-    ADD_INST("label _itn_nil");
-    strcat(INST, s.str);
-    ADD_NEWLINE();
+        // converted value is stored in temporary of its position
+        operand_t temp = expr_temp(expr.depth - 1);
+        if (expr_known(1).not_nil) {
+            ADD_INST2(OP_INT2FLOAT, temp, *top);
+            *top = temp;
+            return;
+        }
+        if (!expr_is_temp(top, &temp)) {
+            ADD_INST2(OP_MOVE, temp, *top);
+        }
+        ADD_INST3(OP_JUMPIFEQ, label, temp, opd_nil());
+        ADD_INST2(OP_INT2FLOAT, temp, temp);
+        ADD_INST1(OP_LABEL, label);
+        *top = temp;
 
-    str_free(&s);
+        counter++;
+        return;
+    }
+
+    ADD_INST1(OP_POPS, common.bool_var);
+    ADD_INST1(OP_PUSHS, common.bool_var);
+    ADD_INST3(OP_JUMPIFEQ, label, common.bool_var, opd_nil());
+    ADD_INST0(OP_INT2FLOATS);
+    ADD_INST1(OP_LABEL, label);
 
     counter++;
 }
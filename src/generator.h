@@ -23,14 +23,28 @@
 #include "expression.h"
 #include "builtin.h"
 
+#define OPT_LEVEL_PEEPHOLE 1    // peephole optimizer over printed code
+#define OPT_LEVEL_COMPARE 1     // <= and >= of integers and strings negate strict comparison
+#define OPT_LEVEL_BRANCH 1      // conditions of if and while jump on compared operands
+#define OPT_LEVEL_ROTATE 1      // condition of while is tested at the end of loop
+#define OPT_LEVEL_SLOTS 1       // locals of disjoint blocks share frame variables
+#define OPT_LEVEL_TAC 2         // expressions are lowered to three address code
+#define OPT_LEVEL_NIL 2         // nil checks of variables known not to be nil are left out
+#define OPT_LEVEL_RANGE 2       // division by zero checks of nonzero divisors are left out
+#define OPT_LEVEL_MAX 2         // level of plain -O
+
+#define EXPR_CACHE 16           // operands of expression kept off the data stack
+#define LOCALS_SIZE 64          // initial size of list of local variables of function
+
 
 extern local_symtab_t *local_tab;   // local symtable from parser
 extern global_symtab_t *global_tab; // global symtable from parser
 extern ibuffer_t *buffer;           // instruction buffer from parser
-extern ibuffer_t *defvar_buffer;    // buffer for declaring variables
 extern parser_helper_t *p_helper;   // get context of parser
+extern int opt_level;               // optimization level from command line (-O)
 
-void generate_name(ibuffer_t *buffer, string_t name);
+atom_t *generate_name(atom_t *name);
+atom_t *generate_name_previous_depth(atom_t *name);
 
 void generate_start();
 void generate_entry();
@@ -41,15 +55,16 @@ void generate_div_by_zero();
 void generate_write_nil();
 void generate_nil_with_operator();
 
-void generate_label(string_t label_name);
+void generate_label(atom_t *label_name);
 void generate_parameters(parser_helper_t *p_helper);
 void generate_retvals();
 void generate_function(parser_helper_t *p_helper);
 void generate_function_end();
-void generate_function_skip_jump(string_t name);
-void generate_function_skip_label(string_t name);
+void generate_function_locals();
+void generate_function_skip_jump(atom_t *name);
+void generate_function_skip_label(atom_t *name);
 
-void generate_identifier(ibuffer_t *buffer, string_t id_name);
+void generate_identifier(atom_t *id_name);
 
 void generate_call_prep(parser_helper_t *p_helper);
 void generate_call_params(token_t *token, parser_helper_t *p_helper);
@@ -58,13 +73,14 @@ void generate_return_value(int ret_counter);
 
 void generate_write(token_t *token);
 
+void generate_expr_init();
 void generate_expr_start();
 void generate_expr_end();
 void generate_push_compare(prec_table_term_t op);
-void generate_push_operator(prec_table_term_t op);
+void generate_push_operator(prec_table_term_t op, int type);
 void generate_push_operand(token_t *token);
 
-void generate_assign(string_t name);
+void generate_assign(atom_t *name);
 void generate_assign_function(parser_helper_t *p_helper);
 
 void generate_else();
@@ -11,87 +11,276 @@
  * @author Adam Zvara
  */
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "ibuffer.h"
+#include "arena.h"
+#include "error.h"
+#include "output.h"
+#include "peephole.h"
+#include "str.h"
 
-/**
- * @brief Create space for single instruction
- */
-char *inst_create(size_t inst_size)
+#define NAME(s) {s, sizeof(s) - 1}
+
+// names of instructions in IFJcode21, indexed by opcode_t
+static const struct {
+    const char *str;
+    unsigned int length;
+} opcode_names[] = {
+    [OP_BLANK] = NAME(""), [OP_HEADER] = NAME(".IFJcode21"), [OP_COMMENT] = NAME(""),
+    [OP_MOVE] = NAME("move"), [OP_CREATEFRAME] = NAME("createframe"),
+    [OP_PUSHFRAME] = NAME("pushframe"), [OP_POPFRAME] = NAME("popframe"),
+    [OP_DEFVAR] = NAME("defvar"), [OP_CALL] = NAME("call"), [OP_RETURN] = NAME("return"),
+    [OP_PUSHS] = NAME("pushs"), [OP_POPS] = NAME("pops"), [OP_CLEARS] = NAME("clears"),
+    [OP_ADD] = NAME("add"), [OP_SUB] = NAME("sub"), [OP_MUL] = NAME("mul"), [OP_DIV] = NAME("div"),
+    [OP_IDIV] = NAME("idiv"), [OP_ADDS] = NAME("adds"), [OP_SUBS] = NAME("subs"),
+    [OP_MULS] = NAME("muls"), [OP_DIVS] = NAME("divs"), [OP_IDIVS] = NAME("idivs"),
+    [OP_LT] = NAME("lt"), [OP_GT] = NAME("gt"), [OP_EQ] = NAME("eq"),
+    [OP_LTS] = NAME("lts"), [OP_GTS] = NAME("gts"), [OP_EQS] = NAME("eqs"),
+    [OP_AND] = NAME("and"), [OP_OR] = NAME("or"), [OP_NOT] = NAME("not"),
+    [OP_ANDS] = NAME("ands"), [OP_ORS] = NAME("ors"), [OP_NOTS] = NAME("nots"),
+    [OP_INT2FLOAT] = NAME("int2float"), [OP_FLOAT2INT] = NAME("float2int"),
+    [OP_INT2CHAR] = NAME("int2char"), [OP_STRI2INT] = NAME("stri2int"),
+    [OP_INT2FLOATS] = NAME("int2floats"), [OP_FLOAT2INTS] = NAME("float2ints"),
+    [OP_INT2CHARS] = NAME("int2chars"), [OP_STRI2INTS] = NAME("stri2ints"),
+    [OP_READ] = NAME("read"), [OP_WRITE] = NAME("write"), [OP_CONCAT] = NAME("concat"),
+    [OP_STRLEN] = NAME("strlen"), [OP_GETCHAR] = NAME("getchar"), [OP_SETCHAR] = NAME("setchar"),
+    [OP_TYPE] = NAME("type"), [OP_LABEL] = NAME("label"), [OP_JUMP] = NAME("jump"),
+    [OP_JUMPIFEQ] = NAME("jumpifeq"), [OP_JUMPIFNEQ] = NAME("jumpifneq"),
+    [OP_JUMPIFEQS] = NAME("jumpifeqs"), [OP_JUMPIFNEQS] = NAME("jumpifneqs"),
+    [OP_EXIT] = NAME("exit"), [OP_BREAK] = NAME("break"), [OP_DPRINT] = NAME("dprint"),
+};
+
+static const char *frame_names[] = {"GF@", "LF@", "TF@"};
+
+operand_t opd_var_name(frame_t frame, const char *name)
 {
-    char *inst = malloc(inst_size);
-    if (inst == NULL) {
-        return NULL;
-    }
-    memset(inst, 0, sizeof(*inst));
+    return opd_var(frame, atom_intern(name, strlen(name)));
+}
 
-    return inst;
+operand_t opd_label_name(const char *name)
+{
+    return opd_label(atom_intern(name, strlen(name)));
 }
 
-ibuffer_t *ibuffer_create(size_t buffer_size, size_t inst_size)
+ibuffer_t *ibuffer_create()
 {
-    // allocate space for ibuffer
-    ibuffer_t *buffer = malloc(sizeof(*buffer) + buffer_size*(sizeof(char *)));
+    ibuffer_t *buffer = arena_alloc(&arena, sizeof(*buffer));
     if (buffer == NULL) {
         return NULL;
     }
 
-    // initialize values
-    buffer->inst_size = inst_size;
-    buffer->size = buffer_size;
-    buffer->length = 0;
-
-    // allocate space for strings in flexible array member
-    for (size_t i = 0; i < buffer->size; i++) {
-        buffer->inst[i] = inst_create(buffer->inst_size);
-        if (buffer->inst[i] == NULL) {
-            return NULL;
-        }
+    buffer->inst = arena_alloc(&arena, IBUFFER_SIZE * sizeof(inst_t));
+    if (buffer->inst == NULL) {
+        return NULL;
     }
+    buffer->size = IBUFFER_SIZE;
+    buffer->length = 0;
 
     return buffer;
 }
 
 void ibuffer_clear(ibuffer_t *buffer)
 {
-    // clear all instructions
-    for (size_t i = 0; i < buffer->length; i++) {
-        memset(buffer->inst[i], 0, sizeof(buffer->inst_size));
+    buffer->length = 0;
+}
+
+// make space for count more instructions
+static int ibuffer_reserve(ibuffer_t *buffer, size_t count)
+{
+    size_t size = buffer->size;
+    while (size - buffer->length < count) {
+        size *= 2;
+    }
+    if (size == buffer->size) {
+        return 0;
     }
 
-    buffer->length = 0;
+    // array is enlarged by doubling, old array is returned to arena
+    inst_t *inst = arena_alloc(&arena, size * sizeof(inst_t));
+    if (inst == NULL) {
+        return ERROR_INTERNAL;
+    }
+    memcpy(inst, buffer->inst, buffer->length * sizeof(inst_t));
+    arena_free(&arena, buffer->inst, buffer->size * sizeof(inst_t));
+    buffer->inst = inst;
+    buffer->size = size;
+
+    return 0;
+}
+
+int ibuffer_add(ibuffer_t *buffer, opcode_t op, operand_t a, operand_t b, operand_t c)
+{
+    if (buffer->length == buffer->size && ibuffer_reserve(buffer, 1)) {
+        return ERROR_INTERNAL;
+    }
+
+    inst_t *inst = &buffer->inst[buffer->length++];
+    inst->op = op;
+    inst->arg[0] = a;
+    inst->arg[1] = b;
+    inst->arg[2] = c;
+
+    return 0;
+}
+
+/**
+ * @brief Upper bound of length of operand in IFJcode21 format
+ */
+static unsigned int operand_length(operand_t *opd)
+{
+    switch (opd->type) {
+        case OPD_NONE:
+            return 0;
+        case OPD_VAR:
+            return 3 + (opd->val.atom != NULL ? opd->val.atom->name.length : 0);
+        case OPD_STRING:
+            // every character can be escaped as \0-nnn
+            return 7 + 6 * opd->val.atom->name.length;
+        case OPD_LABEL:
+            return opd->val.atom->name.length;
+        case OPD_TYPE:
+        case OPD_TEXT:
+            return strlen(opd->val.text);
+        default:
+            // numbers, bool and nil
+            return 32;
+    }
+}
+
+// copy characters to p and move p after them
+static inline char *put(char *p, const char *s, unsigned int n)
+{
+    memcpy(p, s, n);
+    return p + n;
 }
 
-void ibuffer_revert_expression(ibuffer_t *buffer)
+// integer in decimal, same as str_insert_int()
+static char *put_int(char *p, int64_t num)
 {
-    int expr_length = 0;
-    // remove START and END from current expression
-    buffer->inst[0] = "";
-    while (strcmp(buffer->inst[expr_length], "#EXPR END\n")) {
-        expr_length++;
-    }
-    buffer->inst[expr_length++] = "";
-
-    int skip_cnt = 0;
-    for (unsigned int i = 1; i < buffer->length; i++) {
-        if (!strcmp(buffer->inst[i], "#EXPR START\n")) {
-            skip_cnt++;
+    char digits[20];
+    unsigned int i = sizeof(digits);
+    uint64_t value = num < 0 ? -(uint64_t)num : (uint64_t)num;
+
+    do {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    if (num < 0) {
+        *p++ = '-';
+    }
+    return put(p, digits + i, sizeof(digits) - i);
+}
+
+/**
+ * @brief Write string constant, whitespaces, hashtag and backslash are
+ *  written as escape sequences
+ */
+static char *put_string(char *p, string_t string)
+{
+    p = put(p, "string@", 7);
+
+    for (unsigned int i = 0; i < string.length; i++) {
+        char c = string.str[i];
+        if (c > ' ' && c != '#' && c != '\\') {
+            *p++ = c;
+            continue;
+        }
+
+        *p++ = '\\';
+        *p++ = '0';
+        if (c < 10) {
+            *p++ = '0';
         }
+        p = put_int(p, c);
     }
 
-    for (int i = 0; ;i++) {
-        buffer->inst[30][i] = buffer->inst[1][i];
-        if (buffer->inst[1][i] == '\0') break;
+    return p;
+}
+
+/**
+ * @brief Write operand in IFJcode21 format, return end of written text
+ */
+static char *put_operand(char *p, operand_t *opd)
+{
+    switch (opd->type) {
+        case OPD_VAR:
+            p = put(p, frame_names[opd->frame], 3);
+            if (opd->val.atom != NULL) {
+                p = put(p, opd->val.atom->name.str, opd->val.atom->name.length);
+            }
+            return p;
+        case OPD_INT:
+            return put_int(put(p, "int@", 4), opd->val.i);
+        case OPD_FLOAT: {
+            // %a format is created by str_insert_double() in small buffer
+            STR_BUFFERED(number);
+            str_insert_double(&number, opd->val.d);
+            p = put(put(p, "float@", 6), number.str, number.length);
+            str_free(&number);
+            return p;
+        }
+        case OPD_STRING:
+            return put_string(p, opd->val.atom->name);
+        case OPD_BOOL:
+            return opd->val.b ? put(p, "bool@true", 9) : put(p, "bool@false", 10);
+        case OPD_NIL:
+            return put(p, "nil@nil", 7);
+        case OPD_LABEL:
+            return put(p, opd->val.atom->name.str, opd->val.atom->name.length);
+        case OPD_TYPE:
+        case OPD_TEXT:
+            return put(p, opd->val.text, strlen(opd->val.text));
+        default:
+            return p;
     }
 }
 
+void ibuffer_print_inst(inst_t *inst)
+{
+    // space for whole instruction is reserved at once
+    size_t length = opcode_names[inst->op].length + 1;
+    for (int j = 0; j < 3; j++) {
+        length += operand_length(&inst->arg[j]) + 1;
+    }
+    char *p = output_reserve(length);
+    if (p == NULL) {
+        return;
+    }
+
+    p = put(p, opcode_names[inst->op].str, opcode_names[inst->op].length);
+    for (int j = 0; j < 3 && inst->arg[j].type != OPD_NONE; j++) {
+        if (inst->op != OP_COMMENT) {
+            *p++ = ' ';
+        }
+        p = put_operand(p, &inst->arg[j]);
+    }
+    *p++ = '\n';
+    output_commit(p);
+}
+
+inst_t *ibuffer_insert(ibuffer_t *buffer, size_t index, size_t count)
+{
+    if (ibuffer_reserve(buffer, count)) {
+        return NULL;
+    }
+
+    memmove(&buffer->inst[index + count], &buffer->inst[index],
+            (buffer->length - index) * sizeof(inst_t));
+    buffer->length += count;
+
+    return &buffer->inst[index];
+}
+
 void ibuffer_print(ibuffer_t *buffer)
 {
-    // print all instructions
     for (size_t i = 0; i < buffer->length; i++) {
-        printf("%s", buffer->inst[i]);
+        if (peephole.enabled) {
+            peephole_add(&buffer->inst[i]);
+        } else {
+            ibuffer_print_inst(&buffer->inst[i]);
+        }
     }
 }
 
@@ -101,13 +290,7 @@ void ibuffer_destroy(ibuffer_t *buffer)
         return;
     }
 
-    // free strings in buffer
-    for (size_t i = 0; i < buffer->size; i++) {
-        free(buffer->inst[i]);
-    }
-
-    buffer->length = 0;
-    buffer->size = 0;
-
-    free(buffer);
-}
\ No newline at end of file
+    // return instructions and buffer to arena
+    arena_free(&arena, buffer->inst, buffer->size * sizeof(inst_t));
+    arena_free(&arena, buffer, sizeof(*buffer));
+}
@@ -14,55 +14,235 @@
 #ifndef _IBUFFER_H
 #define _IBUFFER_H
 
-#define IBUFFER_SIZE 1000  // size of ibuffer
-#define INSTR_SIZE   200  // size of single instruction
+#define IBUFFER_SIZE 1024   // initial number of instructions in ibuffer
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "atom.h"
 
-// macro for appending instruction into ibuffer
-// ADD_INST(TEST) appends string "TEST" into buffer
-#define ADD_INST(STR)                               \
-do {                                                \
-    strcpy(buffer->inst[buffer->length], STR);      \
-} while (0)                                         \
-
-// macro for appending newline to the end of current instruction
-#define ADD_NEWLINE()                               \
-do {                                                \
-    strcat(buffer->inst[buffer->length], "\n");     \
-    buffer->length++;                               \
-} while (0)                                         \
-
-// append instruction with newline
-#define ADD_INST_N(string)  \
-do {                        \
-    ADD_INST(string);       \
-    ADD_NEWLINE();          \
-} while (0)                 \
-
-#define INST buffer->inst[buffer->length]
+// macros for appending instruction with 0 - 3 operands into ibuffer
+// ADD_INST2(OP_MOVE, a, b) appends instruction "move a b"
+#define ADD_INST0(OP) \
+    ibuffer_add(buffer, OP, opd_none(), opd_none(), opd_none())
+#define ADD_INST1(OP, A) \
+    ibuffer_add(buffer, OP, A, opd_none(), opd_none())
+#define ADD_INST2(OP, A, B) \
+    ibuffer_add(buffer, OP, A, B, opd_none())
+#define ADD_INST3(OP, A, B, C) \
+    ibuffer_add(buffer, OP, A, B, C)
+
+// macro for appending empty line
+#define ADD_BLANK() ADD_INST0(OP_BLANK)
+
+/**
+ * @brief Instructions of IFJcode21 (and few pseudo instructions)
+ */
+typedef enum opcode {
+    OP_BLANK,           // empty line
+    OP_HEADER,          // .IFJcode21
+    OP_COMMENT,         // text of comment in first operand
+    OP_MOVE,
+    OP_CREATEFRAME,
+    OP_PUSHFRAME,
+    OP_POPFRAME,
+    OP_DEFVAR,
+    OP_CALL,
+    OP_RETURN,
+    OP_PUSHS,
+    OP_POPS,
+    OP_CLEARS,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_IDIV,
+    OP_ADDS,
+    OP_SUBS,
+    OP_MULS,
+    OP_DIVS,
+    OP_IDIVS,
+    OP_LT,
+    OP_GT,
+    OP_EQ,
+    OP_LTS,
+    OP_GTS,
+    OP_EQS,
+    OP_AND,
+    OP_OR,
+    OP_NOT,
+    OP_ANDS,
+    OP_ORS,
+    OP_NOTS,
+    OP_INT2FLOAT,
+    OP_FLOAT2INT,
+    OP_INT2CHAR,
+    OP_STRI2INT,
+    OP_INT2FLOATS,
+    OP_FLOAT2INTS,
+    OP_INT2CHARS,
+    OP_STRI2INTS,
+    OP_READ,
+    OP_WRITE,
+    OP_CONCAT,
+    OP_STRLEN,
+    OP_GETCHAR,
+    OP_SETCHAR,
+    OP_TYPE,
+    OP_LABEL,
+    OP_JUMP,
+    OP_JUMPIFEQ,
+    OP_JUMPIFNEQ,
+    OP_JUMPIFEQS,
+    OP_JUMPIFNEQS,
+    OP_EXIT,
+    OP_BREAK,
+    OP_DPRINT,
+} opcode_t;
+
+/**
+ * @brief Types of instruction operands
+ */
+typedef enum operand_type {
+    OPD_NONE,
+    OPD_VAR,            // variable, frame and name
+    OPD_INT,            // constants
+    OPD_FLOAT,
+    OPD_STRING,
+    OPD_BOOL,
+    OPD_NIL,
+    OPD_LABEL,          // label or function name
+    OPD_TYPE,           // type of read instruction (int, float, string ...)
+    OPD_TEXT,           // text of comment
+} operand_type_t;
+
+typedef enum frame {
+    FRAME_GF,
+    FRAME_LF,
+    FRAME_TF,
+} frame_t;
+
+/**
+ * @brief Operand of instruction, variables, strings and labels are atoms,
+ *  so two of them are the same if their atoms are the same
+ */
+typedef struct operand {
+    unsigned char type;         // operand_type_t
+    unsigned char frame;        // frame_t of variable
+    union {
+        atom_t *atom;           // variable name, string constant or label
+        int64_t i;
+        double d;
+        bool b;
+        const char *text;       // type or comment
+    } val;
+} operand_t;
+
+/**
+ * @brief Single instruction stored in ibuffer
+ */
+typedef struct inst {
+    opcode_t op;
+    operand_t arg[3];
+} inst_t;
 
 /**
  * @struct ibuffer
  *
- * @brief Flexible array member for storing instructions during code generation
+ * @brief Growable array of instructions, text of instructions is created
+ *  only when they are printed
  */
 typedef struct ibuffer {
-    size_t inst_size;   // Size of single line
-    size_t size;        // Allocated lines
-    size_t length;      // Used lines (current line)
-    char *inst[];       // Flexible array member containing instructions
+    inst_t *inst;       // instructions
+    size_t size;        // allocated instructions
+    size_t length;      // used instructions
 } ibuffer_t;
 
+/* operand constructors */
+static inline operand_t opd_none()
+{
+    operand_t o = {OPD_NONE, 0, {NULL}};
+    return o;
+}
+
+static inline operand_t opd_var(frame_t frame, atom_t *name)
+{
+    operand_t o = {OPD_VAR, frame, {name}};
+    return o;
+}
+
+static inline operand_t opd_int(int64_t number)
+{
+    operand_t o = {OPD_INT, 0, {NULL}};
+    o.val.i = number;
+    return o;
+}
+
+static inline operand_t opd_float(double number)
+{
+    operand_t o = {OPD_FLOAT, 0, {NULL}};
+    o.val.d = number;
+    return o;
+}
+
+static inline operand_t opd_string(atom_t *string)
+{
+    operand_t o = {OPD_STRING, 0, {string}};
+    return o;
+}
+
+static inline operand_t opd_bool(bool value)
+{
+    operand_t o = {OPD_BOOL, 0, {NULL}};
+    o.val.b = value;
+    return o;
+}
+
+static inline operand_t opd_nil()
+{
+    operand_t o = {OPD_NIL, 0, {NULL}};
+    return o;
+}
+
+static inline operand_t opd_label(atom_t *label)
+{
+    operand_t o = {OPD_LABEL, 0, {label}};
+    return o;
+}
+
+static inline operand_t opd_type(const char *type)
+{
+    operand_t o = {OPD_TYPE, 0, {NULL}};
+    o.val.text = type;
+    return o;
+}
+
+static inline operand_t opd_text(const char *text)
+{
+    operand_t o = {OPD_TEXT, 0, {NULL}};
+    o.val.text = text;
+    return o;
+}
+
 /**
- * @brief Create ibuffer and initialize it's values
+ * @brief Create variable operand from name given as C string
  *
- * @param buffer_size   Size of new buffer
- * @param inst_size     Size of each instruction
+ * @param frame Frame of variable
+ * @param name Name of variable without frame
+ */
+operand_t opd_var_name(frame_t frame, const char *name);
+
+/**
+ * @brief Create label operand from name given as C string
+ */
+operand_t opd_label_name(const char *name);
+
+/**
+ * @brief Create empty ibuffer
  *
  * @return Pointer to allocated buffer, otherwise NULL
  */
-ibuffer_t *ibuffer_create(size_t buffer_size, size_t inst_size);
+ibuffer_t *ibuffer_create();
 
 /**
  * @brief Clear all intructions from buffer and set it to initialized state
@@ -72,24 +252,51 @@ ibuffer_t *ibuffer_create(size_t buffer_size, size_t inst_size);
 void ibuffer_clear(ibuffer_t *buffer);
 
 /**
- * @brief Revert generated expression in buffer
+ * @brief Append instruction to buffer
+ *
+ * @param buffer Pointer to instruction buffer
+ * @param op Instruction
+ * @param a First operand (opd_none() if unused)
+ * @param b Second operand
+ * @param c Third operand
+ *
+ * @return 0 if successful, ERROR_INTERNAL if allocation failed
+ */
+int ibuffer_add(ibuffer_t *buffer, opcode_t op, operand_t a, operand_t b, operand_t c);
+
+/**
+ * @brief Make gap for count instructions before index, instructions after
+ *  it are moved towards the end of buffer
  *
  * @param buffer Pointer to instruction buffer
+ * @param index Position of first instruction of gap
+ * @param count Number of instructions which will be written into gap
+ *
+ * @return Pointer to gap, NULL if allocation failed
  */
-void ibuffer_revert_expression(ibuffer_t *buffer);
+inst_t *ibuffer_insert(ibuffer_t *buffer, size_t index, size_t count);
 
 /**
- * @brief Print out instructions stored in buffer
+ * @brief Print out instructions stored in buffer as IFJcode21 into output
+ *  sink (see output.h), text is written when the sink is flushed, with
+ *  optimizations enabled instructions go through peephole optimizer first
  *
  * @param buffer Pointer to instruction buffer
  */
 void ibuffer_print(ibuffer_t *buffer);
 
 /**
- * @brief Free allocated memory of ibuffer
+ * @brief Print single instruction as IFJcode21 into output sink
+ *
+ * @param inst Instruction
+ */
+void ibuffer_print_inst(inst_t *inst);
+
+/**
+ * @brief Return memory of ibuffer to arena
  *
  * @param buffer Pointer to instruction buffer
  */
 void ibuffer_destroy(ibuffer_t *buffer);
 
-#endif  // _IBUFFER_H
\ No newline at end of file
+#endif  // _IBUFFER_H
@@ -0,0 +1,200 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file nilness.c
+ *
+ * @brief Implementation of nil-ness analysis
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#include <string.h>
+#include "nilness.h"
+#include "arena.h"
+
+nilness_t nilness;
+
+/**
+ * @brief Double size of array allocated from arena, old array is returned
+ *  to arena
+ *
+ * @return New array, NULL if allocation failed
+ */
+static void *nil_grow(void *array, size_t *size, size_t item)
+{
+    size_t grown_size = *size ? 2 * *size : NILNESS_SIZE;
+    void *grown = arena_alloc(&arena, grown_size * item);
+    if (grown == NULL) {
+        nilness.failed = true;
+        return NULL;
+    }
+
+    if (array != NULL) {
+        memcpy(grown, array, *size * item);
+        arena_free(&arena, array, *size * item);
+    }
+    *size = grown_size;
+    return grown;
+}
+
+static void nil_log(nil_change_t **array, size_t *length, size_t *size,
+        struct local_data *var, known_t known)
+{
+    if (*length == *size) {
+        nil_change_t *grown = nil_grow(*array, size, sizeof(nil_change_t));
+        if (grown == NULL) {
+            return;
+        }
+        *array = grown;
+    }
+    (*array)[(*length)++] = (nil_change_t){var, known};
+}
+
+// return states of variables changed after mark
+static void nil_revert(size_t mark)
+{
+    while (nilness.length > mark) {
+        nilness.length--;
+        nilness.log[nilness.length].var->known = nilness.log[nilness.length].known;
+    }
+}
+
+// variable is in saved states between from and to
+static bool nil_saved(size_t from, size_t to, struct local_data *var)
+{
+    for (size_t i = from; i < to; i++) {
+        if (nilness.saved[i].var == var) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void nil_open(unsigned int depth)
+{
+    if (nilness.block_length == nilness.block_size) {
+        nil_block_t *grown = nil_grow(nilness.block, &nilness.block_size, sizeof(nil_block_t));
+        if (grown == NULL) {
+            return;
+        }
+        nilness.block = grown;
+    }
+    nilness.block[nilness.block_length++] =
+        (nil_block_t){depth, nilness.length, nilness.saved_length};
+}
+
+// innermost block, failed analysis can leave it unopened
+static nil_block_t nil_top()
+{
+    if (nilness.block_length == 0) {
+        nilness.failed = true;
+        return (nil_block_t){0, 0, nilness.saved_length};
+    }
+    return nilness.block[nilness.block_length - 1];
+}
+
+void nil_reset()
+{
+    nilness.length = 0;
+    nilness.saved_length = 0;
+    nilness.block_length = 0;
+}
+
+known_t nil_known(struct local_data *var)
+{
+    if (var == NULL || nilness.failed) {
+        return KNOWN_NOTHING;
+    }
+    return var->known;
+}
+
+known_t nil_join(known_t a, known_t b)
+{
+    return (known_t){
+        a.not_nil && b.not_nil,
+        a.min < b.min ? a.min : b.min,
+        a.max > b.max ? a.max : b.max,
+    };
+}
+
+void nil_set(struct local_data *var, known_t known)
+{
+    if (var == NULL) {
+        return;
+    }
+
+    // variables of innermost block are forgotten when block ends
+    if (nilness.block_length > 0 &&
+            var->depth < nilness.block[nilness.block_length - 1].depth) {
+        nil_log(&nilness.log, &nilness.length, &nilness.size, var, var->known);
+    }
+    var->known = known;
+}
+
+void nil_if(unsigned int depth)
+{
+    nil_open(depth);
+}
+
+void nil_else()
+{
+    nil_block_t block = nil_top();
+
+    // states at the end of then branch are kept for nil_if_end()
+    for (size_t i = block.mark; i < nilness.length; i++) {
+        struct local_data *var = nilness.log[i].var;
+        if (!nil_saved(block.saved, nilness.saved_length, var)) {
+            nil_log(&nilness.saved, &nilness.saved_length, &nilness.saved_size,
+                    var, var->known);
+        }
+    }
+    nil_revert(block.mark);
+}
+
+void nil_if_end()
+{
+    nil_block_t block = nil_top();
+    size_t then_length = nilness.saved_length;
+
+    // variables changed in then branch, current state is the one after else
+    for (size_t i = block.saved; i < then_length; i++) {
+        nilness.saved[i].known = nil_join(nilness.saved[i].known, nilness.saved[i].var->known);
+    }
+
+    // variables changed only in else branch, first change holds state before if
+    for (size_t i = block.mark; i < nilness.length; i++) {
+        struct local_data *var = nilness.log[i].var;
+        if (!nil_saved(block.saved, nilness.saved_length, var)) {
+            nil_log(&nilness.saved, &nilness.saved_length, &nilness.saved_size,
+                    var, nil_join(var->known, nilness.log[i].known));
+        }
+    }
+
+    // merged states are changes of enclosing block
+    nil_revert(block.mark);
+    if (nilness.block_length > 0) {
+        nilness.block_length--;
+    }
+    for (size_t i = block.saved; i < nilness.saved_length; i++) {
+        nil_set(nilness.saved[i].var, nilness.saved[i].known);
+    }
+    nilness.saved_length = block.saved;
+}
+
+void nil_loop(unsigned int depth)
+{
+    nil_open(depth);
+}
+
+void nil_loop_end()
+{
+    nil_block_t block = nil_top();
+
+    nil_revert(block.mark);
+    if (nilness.block_length > 0) {
+        nilness.block_length--;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file nilness.h
+ *
+ * @brief Nil-ness analysis, compiler tracks which local variables surely
+ *  don't hold nil and ranges of their integer values, so their nil checks
+ *  and division by zero checks can be left out of generated code
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _NILNESS_H_
+#define _NILNESS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "symtable.h"
+
+#define NILNESS_SIZE 64     // initial size of arrays of analysis
+
+/**
+ * @brief Change of variable state, previous state is restored when branch
+ *  of code ends
+ */
+typedef struct nil_change {
+    struct local_data *var;
+    known_t known;          // state of variable before change
+} nil_change_t;
+
+/**
+ * @brief Block of if or while statement which is being generated
+ */
+typedef struct nil_block {
+    unsigned int depth;     // depth of block, its own variables are not logged
+    size_t mark;            // length of log at the start of block
+    size_t saved;           // length of saved at the start of block
+} nil_block_t;
+
+/**
+ * @brief State of nil-ness analysis of current function
+ */
+typedef struct nilness {
+    nil_change_t *log;      // changes of variables declared outside of blocks
+    size_t length;
+    size_t size;
+    nil_change_t *saved;    // states at the end of then branches
+    size_t saved_length;
+    size_t saved_size;
+    nil_block_t *block;     // open blocks, innermost last
+    size_t block_length;
+    size_t block_size;
+    bool failed;            // allocation failed, nothing is known anymore
+} nilness_t;
+
+extern nilness_t nilness;
+
+/**
+ * @brief Forget blocks of previous function
+ */
+void nil_reset();
+
+/**
+ * @brief What is known about value of variable at current point of code
+ *
+ * @param var Variable, nothing is known about NULL
+ */
+known_t nil_known(struct local_data *var);
+
+/**
+ * @brief Union of two states, value can come from both of them
+ */
+known_t nil_join(known_t a, known_t b);
+
+/**
+ * @brief Set state of variable after assignment, change is logged if
+ *  variable outlives current block
+ *
+ * @param var Assigned variable
+ * @param known What is known about assigned value
+ */
+void nil_set(struct local_data *var, known_t known);
+
+/**
+ * @brief Start then branch of if statement
+ *
+ * @param depth Depth of then branch in local symtable
+ */
+void nil_if(unsigned int depth);
+
+/**
+ * @brief Start else branch, states are returned to the ones before if
+ */
+void nil_else();
+
+/**
+ * @brief End if statement, state of variable is union of its states after
+ *  both branches
+ */
+void nil_if_end();
+
+/**
+ * @brief Start body of while loop, variables which are assigned in body
+ *  have to be set to their state valid in every iteration by nil_set()
+ *  before
+ *
+ * @param depth Depth of body in local symtable
+ */
+void nil_loop(unsigned int depth);
+
+/**
+ * @brief End while loop, states are returned to the ones before loop (body
+ *  could be skipped)
+ */
+void nil_loop_end();
+
+#endif // _NILNESS_H_
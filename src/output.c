@@ -0,0 +1,104 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file output.c
+ *
+ * @brief Implementation of output sink for generated code
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "output.h"
+#include "error.h"
+
+output_t output = {NULL, 0, 0, STDOUT_FILENO, 0, 0, 0};
+
+int output_open(const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return ERROR_INTERNAL;
+    }
+
+    output.fd = fd;
+    return SUCCESS;
+}
+
+char *output_reserve(size_t length)
+{
+    if (output.size - output.length >= length) {
+        return output.data + output.length;
+    }
+
+    if (output.length && output_flush()) {
+        return NULL;
+    }
+
+    // buffer is allocated on first use, single longer text makes it bigger
+    if (output.size < length || output.data == NULL) {
+        size_t size = length > OUTPUT_BUFFER_SIZE ? length : OUTPUT_BUFFER_SIZE;
+        char *data = realloc(output.data, size);
+        if (data == NULL) {
+            return NULL;
+        }
+        output.data = data;
+        output.size = size;
+    }
+
+    return output.data;
+}
+
+int output_flush()
+{
+    const char *p = output.data;
+    size_t left = output.length;
+
+    output.length = 0;
+    if (left == 0 || output.error) {
+        return output.error ? ERROR_INTERNAL : SUCCESS;
+    }
+    output.flushes++;
+
+    // write to pipe can be partial
+    while (left) {
+        ssize_t written = write(output.fd, p, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            output.error = 1;
+            return ERROR_INTERNAL;
+        }
+        p += written;
+        left -= written;
+        output.bytes += written;
+    }
+
+    return SUCCESS;
+}
+
+int output_close()
+{
+    int ret = output_flush();
+
+    if (output.fd != STDOUT_FILENO && close(output.fd)) {
+        ret = ERROR_INTERNAL;
+    }
+
+    free(output.data);
+    output.data = NULL;
+    output.length = output.size = 0;
+    output.fd = STDOUT_FILENO;
+    output.error = 0;
+
+    return ret;
+}
@@ -0,0 +1,82 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file output.h
+ *
+ * @brief Output sink for generated code, text is accumulated in large buffer
+ *  which is written with single write() per flush
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <stddef.h>
+
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)   // buffer is flushed when it's full
+
+/**
+ * @brief Generated code waiting to be written
+ */
+typedef struct output {
+    char *data;         // buffered text
+    size_t length;      // used bytes of data
+    size_t size;        // allocated bytes of data
+    int fd;             // file descriptor of output (stdout by default)
+    int error;          // write failed, rest of output is dropped
+    size_t bytes;       // bytes written to fd
+    size_t flushes;     // number of flushes which wrote something
+} output_t;
+
+extern output_t output;
+
+/**
+ * @brief Open file for output instead of stdout
+ *
+ * @param path Path of output file, it's created or truncated
+ *
+ * @return SUCCESS (0) if successful, otherwise ERROR_INTERNAL
+ */
+int output_open(const char *path);
+
+/**
+ * @brief Get space for at least length bytes at the end of buffer, buffer is
+ *  flushed first if the text would not fit in
+ *
+ * @param length Upper bound of bytes which will be written
+ *
+ * @return Pointer where text should be written, NULL if allocation failed,
+ *  text is added to output by output_commit()
+ */
+char *output_reserve(size_t length);
+
+/**
+ * @brief Add text written after output_reserve() to output
+ *
+ * @param end End of written text
+ */
+static inline void output_commit(char *end)
+{
+    output.length = end - output.data;
+}
+
+/**
+ * @brief Write whole buffer to output
+ *
+ * @return SUCCESS (0) if successful, otherwise ERROR_INTERNAL
+ */
+int output_flush();
+
+/**
+ * @brief Flush buffer, close output file and free buffer, statistics
+ *  (bytes and flushes) are kept
+ *
+ * @return SUCCESS (0) if all output was written, otherwise ERROR_INTERNAL
+ */
+int output_close();
+
+#endif // _OUTPUT_H_
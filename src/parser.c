@@ -13,8 +13,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include "symtable.h"
 #include "scanner.h"
+#include "source.h"
 #include "str.h"
 #include "error.h"
 #include "parser.h"
@@ -23,36 +27,37 @@
 #include "builtin.h"
 #include "expression.h"
 #include "parser_helper.h"
+#include "arena.h"
+#include "output.h"
+#include "peephole.h"
 
 
-token_t *curr_token = NULL;
-token_t *backup_token = NULL;
-token_t *ret_token = NULL;
+token_stream_t tokens;
 
 global_symtab_t *global_tab = NULL;
 local_symtab_t *local_tab = NULL;
 
 ibuffer_t *buffer = NULL;
-ibuffer_t *defvar_buffer = NULL;
 builtin_used_t *builtin_used = NULL;
 
 parser_helper_t *p_helper = NULL;
 
 int ret = SUCCESS;
 
-void token_free()
+int opt_level = 0;
+
+void error_position(int error)
 {
-    FREE_TOK_STRING();
-    free(curr_token);
+    source_pos_t pos;
+
+    // error is reported at token which was read last
+    if (source_position(token_stream_offset(&tokens), &pos) == SUCCESS) {
+        fprintf(stderr, "%zu:%zu: error %d\n", pos.line, pos.column, error);
+    }
 }
 
 int parse()
 {
-    curr_token = malloc(sizeof(token_t));
-    if (!curr_token) {
-        return ERROR_INTERNAL;
-    }
-
     // create global symtable
     global_tab = global_create();
     if (global_tab == NULL) {
@@ -69,60 +74,62 @@ int parse()
     }
 
     // create ibuffer to store generated instructions
-    buffer = ibuffer_create(IBUFFER_SIZE, INSTR_SIZE);
+    buffer = ibuffer_create();
     if (buffer == NULL) {
         return ERROR_INTERNAL;
     }
 
-    // create ibuffer for defvar instruction inside while statement
-    defvar_buffer = ibuffer_create(IBUFFER_SIZE, INSTR_SIZE);
-    if (defvar_buffer == NULL) {
-        return ERROR_INTERNAL;
-    }
-
     // create parser helper
     p_helper = p_helper_create();
     if (p_helper == NULL) {
         return ERROR_INTERNAL;
     }
 
+    // tokenize whole input, parser then only walks the token stream
+    if (token_stream_fill(&tokens)) {
+        return ERROR_INTERNAL;
+    }
+
     ret = require();
+    if (ret && ret != ERROR_INTERNAL) {
+        error_position(ret);
+    }
 
     ibuffer_print(buffer);
+    peephole_flush();
+
+    // write rest of generated code, failed write is internal error
+    if (output_close() && !ret) {
+        ret = ERROR_INTERNAL;
+    }
+
     ibuffer_destroy(buffer);
-    ibuffer_destroy(defvar_buffer);
-    builtin_destroy(builtin_used);
     p_helper_dispose(p_helper);
-    local_destroy(local_tab);
 
     // check if all functions were defined - ret has higher priority
     if (!ret && global_check_declared(global_tab)) {
-        global_destroy(global_tab);
-        return ERROR_SEMANTIC;
+        ret = ERROR_SEMANTIC;
     }
 
     global_destroy(global_tab);
 
-    if (curr_token != NULL) {
-        token_free();
-    }
+    // symtables, ibuffers, helper structures and stack items are released at once
+    arena_release(&arena);
+    token_stream_free(&tokens);
+    atom_destroy();
+    source_close();
 	return ret;
 }
 
 int require()
 {
     // read new token, should be require keyword, also check for failure
-    ret = get_token(curr_token);
-    if (ret)
-        return ret;
+    NEXT_TOKEN();
     if ((GET_TYPE != TOK_KEYWORD) || (GET_KW != KW_REQUIRE))
         return ERROR_SYNTAX;
 
     // check for string after _require_ keyword
-    FREE_TOK_STRING();
-    ret = get_token(curr_token);
-    if (ret)
-        return ret;
+    NEXT_TOKEN();
     if (GET_TYPE != (token_type_t)TOK_STRING)
         return ERROR_SYNTAX;
 
@@ -141,12 +148,7 @@ int prog()
     // entry point has been generated
     static bool entry = false;
 
-    if (!backup_token) {
-        NEXT_TOKEN();
-    } else {
-        curr_token = backup_token;
-        backup_token = NULL;
-    }
+    NEXT_TOKEN();
     if (GET_TYPE == TOK_KEYWORD) { // new token is keyword
         if (GET_KW == KW_GLOBAL) { // check if keyword is _global_
             // get new token that should be ID
@@ -283,7 +285,7 @@ int prog()
         }
 
         // dont create new frame if function is write
-        if (strcmp(p_helper->func->key.str, "write")) {
+        if (strcmp(p_helper->func->key->name.str, "write")) {
             generate_call_prep(p_helper);
         }
 
@@ -461,12 +463,12 @@ int ret_params()
         // current token is COLON so retvals should be empty
         if (p_helper->func_found) {
             if (str_empty(p_helper->func->retvals)) {
-                backup_token = curr_token;
+                UNGET_TOKEN();
                 return ret;
             }
             return ERROR_SEMANTIC;
         }
-        backup_token = curr_token;
+        UNGET_TOKEN();
         return ret;
     }
     NEXT_TOKEN();
@@ -493,7 +495,7 @@ int ret_params_n()
                 return ERROR_SEMANTIC;
             }
         }
-        backup_token = curr_token;
+        UNGET_TOKEN();
         return ret;
     }
     NEXT_TOKEN();
@@ -510,24 +512,11 @@ int ret_params_n()
 
 int body()
 {
-    if (!backup_token) {
-        NEXT_TOKEN();
-    } else {
-        curr_token = backup_token;
-        backup_token = NULL;
-    }
+    NEXT_TOKEN();
 
     // clear helper structure
     p_helper_clear(p_helper);
 
-    // print out instruction buffer
-    if (!str_contains(p_helper->status, 'w')) {
-        ibuffer_print(defvar_buffer);
-        ibuffer_clear(defvar_buffer);
-        ibuffer_print(buffer);
-        ibuffer_clear(buffer);
-    }
-
     if (GET_TYPE == TOK_KEYWORD) {
         switch (GET_KW) {
             case KW_LOCAL:  // Declaration of local variable
@@ -536,13 +525,8 @@ int body()
                     return ERROR_SYNTAX;
 
                 // if variable was defined in this block, return error
-                int index = hash_function(GET_ID);
-                struct local_data *current = local_tab->data[index];
-                while(current) {
-                    if (str_isequal(current->name, GET_ID))
-                        return ERROR_SEMANTIC;
-                    current = current->next;
-                }
+                if (local_find_top(local_tab, GET_ID))
+                    return ERROR_SEMANTIC;
 
                 // if variable has same name as function
                 if (global_find(global_tab, GET_ID))
@@ -551,12 +535,8 @@ int body()
                 // add identifer to local symtable
                 p_helper_add_identifier(p_helper, local_add(local_tab, GET_ID, false));
 
-                // if we are in while statement, append to defvar buffer
-                if (str_contains(p_helper->status, 'w')) {
-                    generate_identifier(defvar_buffer, GET_ID);
-                } else {
-                    generate_identifier(buffer, GET_ID);
-                }
+                // variable is defined in prologue of function
+                generate_identifier(GET_ID);
 
                 NEXT_TOKEN();
                 if (GET_TYPE != TOK_COLON)
@@ -577,10 +557,7 @@ int body()
                 str_add_char(&p_helper->status, 'i');
 
                 // call expression()
-                ret = expression(&backup_token);
-                FREE_TOK_STRING();
-                free(curr_token);
-                curr_token = backup_token;
+                ret = expression();
                 if (ret == EC_FUNC) {
                     return ERROR_SYNTAX;
                 } else if (ret >= T_INT && ret <= T_NIL) {
@@ -601,8 +578,6 @@ int body()
                 if (GET_TYPE != TOK_KEYWORD || GET_KW != KW_THEN)
                     return ERROR_SYNTAX;
 
-                backup_token = NULL;
-
                 // <body>
                 ret = body();
                 if (ret)
@@ -641,10 +616,7 @@ int body()
                 generate_while_start();
 
                 // call expr()
-                ret = expression(&backup_token);
-                FREE_TOK_STRING();
-                free(curr_token);
-                curr_token = backup_token;
+                ret = expression();
                 if (ret == EC_FUNC) {
                     return ERROR_SYNTAX;
                 } else if (ret >= T_INT && ret <= T_NIL) {
@@ -660,8 +632,6 @@ int body()
                 if (GET_TYPE != TOK_KEYWORD || GET_KW != KW_DO)
                     return ERROR_SYNTAX;
 
-                backup_token = NULL;
-
                 // <body>
                 ret = body();
                 if (ret)
@@ -679,6 +649,10 @@ int body()
                 if (local_tab->depth == 0) {
                     // generate return code
                     generate_function_end();
+                    // define local variables and print out whole function
+                    generate_function_locals();
+                    ibuffer_print(buffer);
+                    ibuffer_clear(buffer);
                     // preserve global function in p_helper
                     p_helper->func = global_find(global_tab, local_tab->key);
                     // destroy local symtable for function
@@ -731,7 +705,7 @@ int body()
         p_helper_add_identifier(p_helper, local_find(local_tab, GET_ID));
 
         // Append type of variable being assigned to for later semantic checks
-        struct local_data *tmp = local_find(local_tab, curr_token->attribute.s);
+        struct local_data *tmp = local_find(local_tab, GET_ID);
         if (tmp) {
             switch (tmp->type) {
                 case STR_T:
@@ -763,12 +737,7 @@ int body()
 
 int body_n()
 {
-    if (backup_token) {
-        curr_token = backup_token;
-        backup_token = NULL;
-    } else {
-        NEXT_TOKEN();
-    }
+    NEXT_TOKEN();
 
     if (GET_TYPE == TOK_LBRACKET) {
         // Clear string which is used for storing parameter types
@@ -782,7 +751,7 @@ int body_n()
         builtin_used_update(builtin_used, p_helper->func->key);
 
         // dont create new frame if function is write
-        if (strcmp(p_helper->func->key.str, "write")) {
+        if (strcmp(p_helper->func->key->name.str, "write")) {
             generate_call_prep(p_helper);
         }
 
@@ -809,7 +778,7 @@ int body_n()
         }
 
         // Append type of variable being assigned to for later semantic checks
-        struct local_data *tmp = local_find(local_tab, curr_token->attribute.s);
+        struct local_data *tmp = local_find(local_tab, GET_ID);
         if (tmp) {
             switch (tmp->type) {
                 case STR_T:
@@ -847,8 +816,6 @@ int body_n()
         if (ret)
             return ret;
 
-        //ibuffer_revert_expression(buffer);
-
         return ret;
     } else {
         return ERROR_SYNTAX;
@@ -858,7 +825,7 @@ int body_n()
 int assign_single()
 {
     // call expression()
-    ret = expression(&backup_token);
+    ret = expression();
     if (ret >= T_INT && ret <= T_NIL) {
         // success
         switch (ret)
@@ -891,17 +858,12 @@ int assign_single()
         }
         ret = 0;
         generate_assign(p_helper->id_first->data->name);
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
+        // token after expression is read again by body()
+        UNGET_TOKEN();
         return ret;
 
     } else if (ret == EC_FUNC) {
-        // free curr_token and use token given by expression instead
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
-        backup_token = NULL;
+        // current token is ID of function returned by expression
 
         // perform function call
         p_helper->func = global_find(global_tab, GET_ID);
@@ -939,7 +901,7 @@ int assign_multi()
         p_helper->par_counter++;
 
         // Append type of variable being assigned to for later semantic checks
-        struct local_data *tmp = local_find(local_tab, curr_token->attribute.s);
+        struct local_data *tmp = local_find(local_tab, GET_ID);
         switch (tmp->type) {
             case STR_T:
                 p_helper_call_params_const(p_helper, TOK_STRING);
@@ -972,7 +934,7 @@ int assign_multi()
 int r_side()
 {
     // call expression()
-    ret = expression(&backup_token);
+    ret = expression();
     if (ret >= T_INT && ret <= T_NIL) {
         if (p_helper->assign) {
             // assign value to variable
@@ -1012,16 +974,9 @@ int r_side()
         }
         // success
         ret = 0;
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
         return r_side_n();
     } else if (ret == EC_FUNC) {
-        // free curr_token and use token given by expression instead
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
-        backup_token = NULL;
+        // current token is ID of function returned by expression
 
         // perform function call
         p_helper->func = global_find(global_tab, GET_ID);
@@ -1052,16 +1007,11 @@ int r_side()
 
 int r_side_n()
 {
-    if (backup_token) {
-        curr_token = backup_token;
-        backup_token = NULL;
-    } else
-        NEXT_TOKEN();
-
+    // current token was already read by expression
     if (GET_TYPE == TOK_COMMA) {
         return r_side();
     } else {
-        backup_token = curr_token;
+        UNGET_TOKEN();
         return ret;
     }
 }
@@ -1073,7 +1023,7 @@ int init()
         p_helper->id_first->data->init = true;
         return init_n();
     } else {
-        backup_token = curr_token;
+        UNGET_TOKEN();
         return ret;
     }
 }
@@ -1081,7 +1031,7 @@ int init()
 int init_n()
 {
     // call expression()
-    ret = expression(&backup_token);
+    ret = expression();
     if (ret >= T_INT && ret <= T_NIL) {
         // success, check return type with variable type
         switch (ret)
@@ -1113,16 +1063,11 @@ int init_n()
         }
         ret = 0;
         generate_assign(p_helper->id_first->data->name);
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
+        // token after expression is read again by body()
+        UNGET_TOKEN();
         return ret;
     } else if (ret == EC_FUNC) {
-        // free curr_token and use token given by expression instead
-        FREE_TOK_STRING();
-        free(curr_token);
-        curr_token = backup_token;
-        backup_token = NULL;
+        // current token is ID of function returned by expression
 
         p_helper->func = global_find(global_tab, GET_ID);
         p_helper->assign = true;
@@ -1165,9 +1110,11 @@ int init_n()
 
 int args()
 {
+    token_t token;
+
     NEXT_TOKEN();
     if (GET_TYPE == TOK_RBRACKET) {
-        if (!strcmp(p_helper->func->key.str, "write")) {
+        if (!strcmp(p_helper->func->key->name.str, "write")) {
             // special case for write functions - variadic functions
             // parameters are not checked
             return ret;
@@ -1198,26 +1145,30 @@ int args()
 
     if (GET_TYPE == TOK_STRING || GET_TYPE == TOK_DECIMAL || GET_TYPE == TOK_INT ||
             (GET_TYPE == TOK_KEYWORD && GET_KW == KW_NIL)) {
-        if (!strcmp(p_helper->func->key.str, "write")) {
+        if (!strcmp(p_helper->func->key->name.str, "write")) {
             // instructions are generated on spot
-            generate_write(curr_token);
+            token_stream_get(&tokens, &token);
+            generate_write(&token);
             return args_n();
         }
         p_helper_call_params_const(p_helper, GET_TYPE);
-        generate_call_params(curr_token, p_helper);
+        token_stream_get(&tokens, &token);
+        generate_call_params(&token, p_helper);
         return args_n();
     } else if (GET_TYPE == TOK_ID) {
         if (local_find(local_tab, GET_ID) == NULL) {
             return ERROR_SEMANTIC;
         }
 
-        if (!strcmp(p_helper->func->key.str, "write")) {
+        if (!strcmp(p_helper->func->key->name.str, "write")) {
             // instructions are generated on spot
-            generate_write(curr_token);
+            token_stream_get(&tokens, &token);
+            generate_write(&token);
             return args_n();
         }
         p_helper_call_params_id(p_helper, GET_ID);
-        generate_call_params(curr_token, p_helper);
+        token_stream_get(&tokens, &token);
+        generate_call_params(&token, p_helper);
         return args_n();
     } else {
         return ERROR_SYNTAX;
@@ -1229,7 +1180,7 @@ int args_n() {
     if (GET_TYPE == TOK_COMMA) {
         return args();
     } else if (GET_TYPE == TOK_RBRACKET) {
-        if (!strcmp(p_helper->func->key.str, "write")) {
+        if (!strcmp(p_helper->func->key->name.str, "write")) {
             // special case for write functions - variadic functions
             // parameters are not checked
             return ret;
@@ -1262,8 +1213,42 @@ int args_n() {
 }
 
 
-int main() {
+int main(int argc, char *argv[])
+{
+    bool stats = false;
+
+    // -o FILE writes generated code into FILE, -s prints output statistics,
+    // -O1 enables peephole optimizer, -O2 (-O) also three address code,
+    // -O0 disables optimizations
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-O") == 0) {
+            opt_level = OPT_LEVEL_MAX;
+        } else if (strncmp(argv[i], "-O", 2) == 0 && isdigit(argv[i][2]) && !argv[i][3]) {
+            opt_level = argv[i][2] - '0';
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            if (output_open(argv[++i])) {
+                fprintf(stderr, "cannot open output file %s\n", argv[i]);
+                return ERROR_INTERNAL;
+            }
+        } else if (strcmp(argv[i], "-s") == 0) {
+            stats = true;
+        } else {
+            fprintf(stderr, "usage: %s [-O] [-o file] [-s] < input\n", argv[0]);
+            return ERROR_INTERNAL;
+        }
+    }
+
+    peephole.enabled = opt_level >= OPT_LEVEL_PEEPHOLE;
+
     int ret_main = parse();
-    //fprintf(stderr, "%d", ret_main);
+
+    if (stats) {
+        fprintf(stderr, "output: %zu bytes, %zu flushes\n", output.bytes, output.flushes);
+    }
+    if (stats && peephole.enabled) {
+        fprintf(stderr, "peephole: pushs/pops to move %zu, pushs/pops removed %zu, "
+                "jump to next label %zu\n", peephole.fired[RULE_PUSH_POP],
+                peephole.fired[RULE_ROUND_TRIP], peephole.fired[RULE_JUMP_NEXT]);
+    }
     return ret_main;
 }
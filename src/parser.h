@@ -14,24 +14,27 @@
 #ifndef _PARSER_H_
 #define _PARSER_H_
 
-#define FREE_TOK_STRING() \
-    do {               \
-		if (curr_token->type == TOK_STRING || curr_token->type == TOK_ID) \
-			str_free(&curr_token->attribute.s); \
-    } while(0);          \
+#include "token_stream.h"
+
+extern token_stream_t tokens;   // tokens of whole input
 
 #define NEXT_TOKEN() \
     do  {             \
-        FREE_TOK_STRING()    \
-        ret = get_token(curr_token); \
+        ret = token_stream_next(&tokens); \
         if (ret) {     \
             return ret; \
         }    \
     } while(0); \
 
-#define GET_ID curr_token->attribute.s
-#define GET_KW curr_token->attribute.keyword
-#define GET_TYPE curr_token->type
+// current token is read again by next NEXT_TOKEN()
+#define UNGET_TOKEN() token_stream_unget(&tokens)
+
+#define GET_ID TOKEN_VALUE(&tokens).id
+#define GET_KW TOKEN_KEYWORD(&tokens)
+#define GET_TYPE TOKEN_TYPE(&tokens)
+
+// print line and column of token at which error was found to stderr
+void error_position(int error);
 
 int parse();
 int require();
@@ -12,11 +12,12 @@
  */
 
 #include "parser_helper.h"
+#include "arena.h"
 #include "error.h"      // ERROR TYPES
 
 parser_helper_t *p_helper_create()
 {
-    parser_helper_t *f = malloc(sizeof(*f));
+    parser_helper_t *f = arena_alloc(&arena, sizeof(*f));
     if (f == NULL) {
         return NULL;
     }
@@ -65,12 +66,11 @@ void p_helper_dispose(parser_helper_t *f)
 
     str_free(&f->temp);
     str_free(&f->status);
-    free(f);
 }
 
 int p_helper_add_identifier(parser_helper_t *f, struct local_data *id)
 {
-    struct identifiers *new_id = malloc(sizeof(*new_id));
+    struct identifiers *new_id = arena_alloc(&arena, sizeof(*new_id));
     if (new_id == NULL) {
         return ERROR_INTERNAL;
     }
@@ -97,7 +97,7 @@ void p_helper_delete_identifier(parser_helper_t *f)
     }
 
     f->id_first = del->next;
-    free(del);
+    arena_free(&arena, del, sizeof(*del));
 
     if (f->id_first == NULL) {
         f->id_last = NULL;
@@ -214,7 +214,7 @@ int p_helper_call_params_const(parser_helper_t *f, token_type_t type)
     return 0;
 }
 
-int p_helper_call_params_id(parser_helper_t *f, string_t name)
+int p_helper_call_params_id(parser_helper_t *f, atom_t *name)
 {
     if (local_tab == NULL) {
         return 1;
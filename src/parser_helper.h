@@ -107,6 +107,6 @@ int p_helper_call_params_const(parser_helper_t *f, token_type_t type);
  * @param name Name of identifier
  * @return 0 if ID was found and added, otherwise 1
  */
-int p_helper_call_params_id(parser_helper_t *f, string_t name);
+int p_helper_call_params_id(parser_helper_t *f, atom_t *name);
 
 #endif
\ No newline at end of file
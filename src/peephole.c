@@ -0,0 +1,186 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file peephole.c
+ *
+ * @brief Implementation of peephole optimizer
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#include <string.h>
+#include "peephole.h"
+
+peephole_t peephole;
+
+void peephole_exit_label(atom_t *label)
+{
+    if (peephole.exit_count < PEEPHOLE_EXITS) {
+        peephole.exits[peephole.exit_count++] = label;
+    }
+}
+
+// operands are the same variable, constant or label
+static bool opd_equal(operand_t *a, operand_t *b)
+{
+    if (a->type != b->type) {
+        return false;
+    }
+
+    switch (a->type) {
+        case OPD_VAR:
+            return a->frame == b->frame && a->val.atom == b->val.atom;
+        case OPD_STRING:
+        case OPD_LABEL:
+            return a->val.atom == b->val.atom;
+        case OPD_INT:
+            return a->val.i == b->val.i;
+        case OPD_FLOAT:
+            return memcmp(&a->val.d, &b->val.d, sizeof(double)) == 0;
+        case OPD_BOOL:
+            return a->val.b == b->val.b;
+        case OPD_NONE:
+        case OPD_NIL:
+            return true;
+        default:
+            return a->val.text == b->val.text;
+    }
+}
+
+// conditional jump to runtime error
+static bool is_exit_jump(inst_t *inst)
+{
+    if (inst->op != OP_JUMPIFEQ && inst->op != OP_JUMPIFNEQ) {
+        return false;
+    }
+
+    for (size_t i = 0; i < peephole.exit_count; i++) {
+        if (inst->arg[0].val.atom == peephole.exits[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Instruction does not use data stack, does not change control flow
+ *  (except for runtime errors) and writes only its first operand
+ */
+static bool is_transparent(inst_t *inst)
+{
+    switch (inst->op) {
+        case OP_BLANK:
+        case OP_COMMENT:
+        case OP_MOVE:
+        case OP_TYPE:
+            return true;
+        default:
+            return is_exit_jump(inst);
+    }
+}
+
+static void window_remove(size_t index)
+{
+    memmove(&peephole.window[index], &peephole.window[index + 1],
+            (peephole.length - index - 1) * sizeof(inst_t));
+    peephole.length--;
+}
+
+/**
+ * @brief Replace pushs X followed by pops Y with move Y X, pushed value stays
+ *  in X if nothing between them writes X or Y
+ *
+ * @param inst pops instruction, it's rewritten to move
+ *
+ * @return true if instruction should be dropped (pops of pushed variable)
+ */
+static bool rule_push_pop(inst_t *inst)
+{
+    operand_t *y = &inst->arg[0];
+
+    size_t i = peephole.length;
+    while (i > 0 && peephole.window[i - 1].op != OP_PUSHS) {
+        if (!is_transparent(&peephole.window[i - 1])) {
+            return false;
+        }
+        i--;
+    }
+    if (i == 0) {
+        return false;
+    }
+
+    operand_t x = peephole.window[i - 1].arg[0];
+    for (size_t j = i; j < peephole.length; j++) {
+        operand_t *written = &peephole.window[j].arg[0];
+        if ((peephole.window[j].op == OP_MOVE || peephole.window[j].op == OP_TYPE) &&
+            (opd_equal(written, &x) || opd_equal(written, y))) {
+            return false;
+        }
+    }
+
+    window_remove(i - 1);
+    if (opd_equal(&x, y)) {
+        peephole.fired[RULE_ROUND_TRIP]++;
+        return true;
+    }
+
+    inst->op = OP_MOVE;
+    inst->arg[1] = x;
+    peephole.fired[RULE_PUSH_POP]++;
+    return false;
+}
+
+/**
+ * @brief Remove jump to label if only labels are between jump and label
+ *
+ * @param inst label instruction
+ */
+static void rule_jump_next(inst_t *inst)
+{
+    for (size_t i = peephole.length; i-- > 0;) {
+        inst_t *prev = &peephole.window[i];
+
+        if (prev->op == OP_JUMP && prev->arg[0].val.atom == inst->arg[0].val.atom) {
+            window_remove(i);
+            peephole.fired[RULE_JUMP_NEXT]++;
+            return;
+        }
+        if (prev->op != OP_LABEL && prev->op != OP_BLANK && prev->op != OP_COMMENT) {
+            return;
+        }
+    }
+}
+
+void peephole_add(inst_t *inst)
+{
+    inst_t next = *inst;
+
+    if (next.op == OP_POPS && rule_push_pop(&next)) {
+        return;
+    }
+    if (next.op == OP_LABEL) {
+        rule_jump_next(&next);
+    }
+
+    if (peephole.length == PEEPHOLE_WINDOW) {
+        // older half is printed at once, newer half stays for next rules
+        size_t half = PEEPHOLE_WINDOW / 2;
+        for (size_t i = 0; i < half; i++) {
+            ibuffer_print_inst(&peephole.window[i]);
+        }
+        memmove(peephole.window, &peephole.window[half], half * sizeof(inst_t));
+        peephole.length = half;
+    }
+    peephole.window[peephole.length++] = next;
+}
+
+void peephole_flush()
+{
+    for (size_t i = 0; i < peephole.length; i++) {
+        ibuffer_print_inst(&peephole.window[i]);
+    }
+    peephole.length = 0;
+}
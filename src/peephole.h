@@ -0,0 +1,70 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file peephole.h
+ *
+ * @brief Peephole optimizer, printed instructions pass through small window
+ *  in which redundant instruction sequences are rewritten
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _PEEPHOLE_H_
+#define _PEEPHOLE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "ibuffer.h"
+
+#define PEEPHOLE_WINDOW 32  // instructions waiting for following instructions
+#define PEEPHOLE_EXITS 4    // labels of code which only exits program
+
+/**
+ * @brief Rewrite rules of peephole optimizer
+ */
+typedef enum peephole_rule {
+    RULE_PUSH_POP,      // pushs X ... pops Y   -> move Y X
+    RULE_ROUND_TRIP,    // pushs X ... pops X   -> (nothing)
+    RULE_JUMP_NEXT,     // jump L, label L      -> label L
+    RULE_COUNT,
+} peephole_rule_t;
+
+/**
+ * @brief State of peephole optimizer
+ */
+typedef struct peephole {
+    bool enabled;                       // instructions are optimized (-O)
+    inst_t window[PEEPHOLE_WINDOW];     // instructions which were not printed yet
+    size_t length;                      // used instructions of window
+    atom_t *exits[PEEPHOLE_EXITS];      // jumps to them need no stack nor variables
+    size_t exit_count;
+    size_t fired[RULE_COUNT];           // how many times rule was applied
+} peephole_t;
+
+extern peephole_t peephole;
+
+/**
+ * @brief Mark label as runtime error exit, conditional jump to it can be
+ *  moved over by rules
+ *
+ * @param label Label followed only by exit instruction
+ */
+void peephole_exit_label(atom_t *label);
+
+/**
+ * @brief Add instruction to window, oldest instruction is printed when
+ *  window is full
+ *
+ * @param inst Instruction to be printed
+ */
+void peephole_add(inst_t *inst);
+
+/**
+ * @brief Print all instructions left in window
+ */
+void peephole_flush();
+
+#endif // _PEEPHOLE_H_
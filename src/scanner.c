@@ -15,37 +15,322 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #include "scanner.h"
+#include "source.h"
 #include "error.h"
 
-#define STATE_START 1
-#define STATE_ID_OR_KEYWORD 2
-#define STATE_MINUS 3
-#define STATE_COMMENT 4
-#define STATE_DIV 5
-#define STATE_ASSIGN 6
-#define STATE_EQUAL 7
-#define STATE_LESS 8
-#define STATE_GREAT 9
-#define STATE_NOT_EQUAL 10
-#define STATE_NUMBER 11
-#define STATE_NUMBER_POINT 12
-#define STATE_NUMBER_DEC 13
-#define STATE_NUMBER_E 14
-#define STATE_NUMBER_EXP_SIGN 15
-#define STATE_NUMBER_EXP_END 16
-#define STATE_CONCAT 17
-#define STATE_STRING 18
-#define STATE_BLOCK_COMMENT_FIRST 19
-#define STATE_BLOCK_COMMENT 20
-#define STATE_BLOCK_COMMENT_LEAVE 21
-#define STATE_STRING_ESCAPE 22
-#define STATE_STRING_ESCAPE_NUM_1 23
-#define STATE_STRING_ESCAPE_NUM_2 24
-#define STATE_STRING_ESCAPE_NUM_3 25
-#define STATE_LINE_COMMENT 26
+// long runs of whitespace and string bodies are searched 16 bytes at once
+#if defined(__GNUC__) && defined(__SSE2__) && !defined(SCANNER_NO_SIMD)
+#define SCANNER_SIMD
+#include <emmintrin.h>
+#endif
+
+// character classes, characters of the same class behave the same way in
+// every state of the automaton (see doc/img/FSM.png)
+typedef enum {
+	CLASS_EOF,
+	CLASS_INVALID,		// ascii values lower than 32 and bytes above 127
+	CLASS_NEWLINE,		// '\n'
+	CLASS_SPACE,		// ' '
+	CLASS_CTRL_SPACE,	// '\t', '\v', '\f', '\r'
+	CLASS_LETTER,		// letters and '_' not covered by classes below
+	CLASS_E,			// 'e', 'E' (exponent of number)
+	CLASS_T,			// 't' (escape sequence)
+	CLASS_N,			// 'n' (escape sequence)
+	CLASS_DIGIT,
+	CLASS_DOT,
+	CLASS_PLUS,
+	CLASS_MINUS,
+	CLASS_MUL,
+	CLASS_SLASH,
+	CLASS_HASH,
+	CLASS_LBRACKET,		// (
+	CLASS_RBRACKET,		// )
+	CLASS_COLON,
+	CLASS_COMMA,
+	CLASS_TILDE,
+	CLASS_LESS,
+	CLASS_GREAT,
+	CLASS_EQUAL,
+	CLASS_QUOTE,
+	CLASS_BACKSLASH,
+	CLASS_LSQUARE,		// [
+	CLASS_RSQUARE,		// ]
+	CLASS_OTHER,		// remaining printable characters
+	CLASS_COUNT,
+} char_class_t;
+
+// states of the automaton, states before STATE_COUNT read next character,
+// the rest are final (token is finished or lexical error was found)
+typedef enum {
+	STATE_START,
+	STATE_ID_BEGIN,
+	STATE_ID,
+	STATE_MINUS,
+	STATE_COMMENT,
+	STATE_LINE_COMMENT,
+	STATE_BLOCK_COMMENT_FIRST,
+	STATE_BLOCK_COMMENT,
+	STATE_BLOCK_COMMENT_LEAVE,
+	STATE_DIV,
+	STATE_EQUAL,
+	STATE_LESS,
+	STATE_GREAT,
+	STATE_NOT_EQUAL,
+	STATE_CONCAT,
+	STATE_NUMBER,
+	STATE_NUMBER_POINT,
+	STATE_NUMBER_DEC,
+	STATE_NUMBER_E,
+	STATE_NUMBER_EXP_SIGN,
+	STATE_NUMBER_EXP_END,
+	STATE_STRING_BEGIN,
+	STATE_STRING,
+	STATE_STRING_ESCAPE,
+	STATE_STRING_ESCAPE_CHAR,
+	STATE_STRING_ESCAPE_NUM_1,
+	STATE_STRING_ESCAPE_NUM_2,
+	STATE_STRING_ESCAPE_NUM_3,
+	STATE_COUNT,
+
+	// operators, EOF (last character is returned back if it's not part of token)
+	ACCEPT_EOF = STATE_COUNT,
+	ACCEPT_LBRACKET,
+	ACCEPT_RBRACKET,
+	ACCEPT_PLUS,
+	ACCEPT_MINUS,
+	ACCEPT_LEN,
+	ACCEPT_MUL,
+	ACCEPT_DIV,
+	ACCEPT_INT_DIV,
+	ACCEPT_COLON,
+	ACCEPT_COMMA,
+	ACCEPT_CONCAT,
+	ACCEPT_NEQ,
+	ACCEPT_LES,
+	ACCEPT_LES_EQ,
+	ACCEPT_GR,
+	ACCEPT_GR_EQ,
+	ACCEPT_ASSIGN,
+	ACCEPT_EQ,
+	// tokens with attribute
+	ACCEPT_ID,
+	ACCEPT_INT,
+	ACCEPT_DOUBLE,
+	ACCEPT_STRING,
+	// lexical errors, last character is consumed or returned back
+	STATE_ERROR,
+	STATE_ERROR_UNGET,
+	STATE_ALL_COUNT,
+} scanner_state_t;
+
+// token type of final operator states and whether last character is returned
+static const struct {
+	token_type_t type;
+	bool unget;
+} accept_table[STATE_ALL_COUNT] = {
+	[ACCEPT_EOF] = {TOK_EOF, false},
+	[ACCEPT_LBRACKET] = {TOK_LBRACKET, false},
+	[ACCEPT_RBRACKET] = {TOK_RBRACKET, false},
+	[ACCEPT_PLUS] = {TOK_PLUS, false},
+	[ACCEPT_MINUS] = {TOK_MINUS, true},
+	[ACCEPT_LEN] = {TOK_LEN, false},
+	[ACCEPT_MUL] = {TOK_MUL, false},
+	[ACCEPT_DIV] = {TOK_DIV, true},
+	[ACCEPT_INT_DIV] = {TOK_INT_DIV, false},
+	[ACCEPT_COLON] = {TOK_COLON, false},
+	[ACCEPT_COMMA] = {TOK_COMMA, false},
+	[ACCEPT_CONCAT] = {TOK_CONCAT, false},
+	[ACCEPT_NEQ] = {TOK_NEQ, false},
+	[ACCEPT_LES] = {TOK_LES, true},
+	[ACCEPT_LES_EQ] = {TOK_LES_EQ, false},
+	[ACCEPT_GR] = {TOK_GR, true},
+	[ACCEPT_GR_EQ] = {TOK_GR_EQ, false},
+	[ACCEPT_ASSIGN] = {TOK_ASSIGN, true},
+	[ACCEPT_EQ] = {TOK_EQ, false},
+};
+
+// class of every byte of input shifted by one, char_class[0] is class of EOF
+static unsigned char char_class[257];
+
+// next state for every non-final state and character class
+static unsigned char transition[STATE_COUNT][CLASS_COUNT];
+
+static bool fsm_ready = false;
+
+#define CHAR_CLASS(c) (char_class[(c) + 1])
+
+// set class of all given characters
+static void fsm_class(const char *chars, char_class_t class)
+{
+	for (; *chars != '\0'; chars++) {
+		CHAR_CLASS((unsigned char)*chars) = class;
+	}
+}
 
+// set all transitions of state to default state
+static void fsm_row(scanner_state_t state, scanner_state_t other)
+{
+	memset(transition[state], other, CLASS_COUNT);
+}
+
+static void fsm_set(scanner_state_t state, char_class_t class, scanner_state_t next)
+{
+	transition[state][class] = next;
+}
+
+// fill character class and transition tables from the FSM of scanner
+static void fsm_init()
+{
+	CHAR_CLASS(EOF) = CLASS_EOF;
+	for (int c = 0; c < 256; c++) {
+		if (c < 32 || c >= 128) {
+			CHAR_CLASS(c) = CLASS_INVALID;
+		} else if (isalpha(c) || c == '_') {
+			CHAR_CLASS(c) = CLASS_LETTER;
+		} else if (isdigit(c)) {
+			CHAR_CLASS(c) = CLASS_DIGIT;
+		} else {
+			CHAR_CLASS(c) = CLASS_OTHER;
+		}
+	}
+	fsm_class("\n", CLASS_NEWLINE);
+	fsm_class(" ", CLASS_SPACE);
+	fsm_class("\t\v\f\r", CLASS_CTRL_SPACE);
+	fsm_class("eE", CLASS_E);
+	fsm_class("t", CLASS_T);
+	fsm_class("n", CLASS_N);
+	fsm_class(".", CLASS_DOT);
+	fsm_class("+", CLASS_PLUS);
+	fsm_class("-", CLASS_MINUS);
+	fsm_class("*", CLASS_MUL);
+	fsm_class("/", CLASS_SLASH);
+	fsm_class("#", CLASS_HASH);
+	fsm_class("(", CLASS_LBRACKET);
+	fsm_class(")", CLASS_RBRACKET);
+	fsm_class(":", CLASS_COLON);
+	fsm_class(",", CLASS_COMMA);
+	fsm_class("~", CLASS_TILDE);
+	fsm_class("<", CLASS_LESS);
+	fsm_class(">", CLASS_GREAT);
+	fsm_class("=", CLASS_EQUAL);
+	fsm_class("\"", CLASS_QUOTE);
+	fsm_class("\\", CLASS_BACKSLASH);
+	fsm_class("[", CLASS_LSQUARE);
+	fsm_class("]", CLASS_RSQUARE);
+
+	fsm_row(STATE_START, STATE_ERROR);
+	fsm_set(STATE_START, CLASS_SPACE, STATE_START);
+	fsm_set(STATE_START, CLASS_CTRL_SPACE, STATE_START);
+	fsm_set(STATE_START, CLASS_NEWLINE, STATE_START);
+	fsm_set(STATE_START, CLASS_EOF, ACCEPT_EOF);
+	fsm_set(STATE_START, CLASS_LBRACKET, ACCEPT_LBRACKET);
+	fsm_set(STATE_START, CLASS_RBRACKET, ACCEPT_RBRACKET);
+	fsm_set(STATE_START, CLASS_PLUS, ACCEPT_PLUS);
+	fsm_set(STATE_START, CLASS_HASH, ACCEPT_LEN);
+	fsm_set(STATE_START, CLASS_MUL, ACCEPT_MUL);
+	fsm_set(STATE_START, CLASS_COLON, ACCEPT_COLON);
+	fsm_set(STATE_START, CLASS_COMMA, ACCEPT_COMMA);
+	fsm_set(STATE_START, CLASS_SLASH, STATE_DIV);
+	fsm_set(STATE_START, CLASS_MINUS, STATE_MINUS);
+	fsm_set(STATE_START, CLASS_DOT, STATE_CONCAT);
+	fsm_set(STATE_START, CLASS_TILDE, STATE_NOT_EQUAL);
+	fsm_set(STATE_START, CLASS_GREAT, STATE_GREAT);
+	fsm_set(STATE_START, CLASS_LESS, STATE_LESS);
+	fsm_set(STATE_START, CLASS_EQUAL, STATE_EQUAL);
+	fsm_set(STATE_START, CLASS_LETTER, STATE_ID_BEGIN);
+	fsm_set(STATE_START, CLASS_E, STATE_ID_BEGIN);
+	fsm_set(STATE_START, CLASS_T, STATE_ID_BEGIN);
+	fsm_set(STATE_START, CLASS_N, STATE_ID_BEGIN);
+	fsm_set(STATE_START, CLASS_DIGIT, STATE_NUMBER);
+	fsm_set(STATE_START, CLASS_QUOTE, STATE_STRING_BEGIN);
+
+	// identifiers and keywords
+	fsm_row(STATE_ID, ACCEPT_ID);
+	fsm_set(STATE_ID, CLASS_LETTER, STATE_ID);
+	fsm_set(STATE_ID, CLASS_E, STATE_ID);
+	fsm_set(STATE_ID, CLASS_T, STATE_ID);
+	fsm_set(STATE_ID, CLASS_N, STATE_ID);
+	fsm_set(STATE_ID, CLASS_DIGIT, STATE_ID);
+	memcpy(transition[STATE_ID_BEGIN], transition[STATE_ID], CLASS_COUNT);
+
+	// operators
+	fsm_row(STATE_DIV, ACCEPT_DIV);
+	fsm_set(STATE_DIV, CLASS_SLASH, ACCEPT_INT_DIV);
+	fsm_row(STATE_CONCAT, STATE_ERROR_UNGET);
+	fsm_set(STATE_CONCAT, CLASS_DOT, ACCEPT_CONCAT);
+	fsm_row(STATE_NOT_EQUAL, STATE_ERROR_UNGET);
+	fsm_set(STATE_NOT_EQUAL, CLASS_EQUAL, ACCEPT_NEQ);
+	fsm_row(STATE_GREAT, ACCEPT_GR);
+	fsm_set(STATE_GREAT, CLASS_EQUAL, ACCEPT_GR_EQ);
+	fsm_row(STATE_LESS, ACCEPT_LES);
+	fsm_set(STATE_LESS, CLASS_EQUAL, ACCEPT_LES_EQ);
+	fsm_row(STATE_EQUAL, ACCEPT_ASSIGN);
+	fsm_set(STATE_EQUAL, CLASS_EQUAL, ACCEPT_EQ);
+
+	// numbers
+	fsm_row(STATE_NUMBER, ACCEPT_INT);
+	fsm_set(STATE_NUMBER, CLASS_DIGIT, STATE_NUMBER);
+	fsm_set(STATE_NUMBER, CLASS_DOT, STATE_NUMBER_POINT);
+	fsm_set(STATE_NUMBER, CLASS_E, STATE_NUMBER_E);
+	fsm_row(STATE_NUMBER_POINT, STATE_ERROR_UNGET);
+	fsm_set(STATE_NUMBER_POINT, CLASS_DIGIT, STATE_NUMBER_DEC);
+	fsm_row(STATE_NUMBER_DEC, ACCEPT_DOUBLE);
+	fsm_set(STATE_NUMBER_DEC, CLASS_DIGIT, STATE_NUMBER_DEC);
+	fsm_set(STATE_NUMBER_DEC, CLASS_E, STATE_NUMBER_E);
+	fsm_row(STATE_NUMBER_E, STATE_ERROR_UNGET);
+	fsm_set(STATE_NUMBER_E, CLASS_DIGIT, STATE_NUMBER_EXP_END);
+	fsm_set(STATE_NUMBER_E, CLASS_PLUS, STATE_NUMBER_EXP_SIGN);
+	fsm_set(STATE_NUMBER_E, CLASS_MINUS, STATE_NUMBER_EXP_SIGN);
+	fsm_row(STATE_NUMBER_EXP_SIGN, STATE_ERROR_UNGET);
+	fsm_set(STATE_NUMBER_EXP_SIGN, CLASS_DIGIT, STATE_NUMBER_EXP_END);
+	fsm_row(STATE_NUMBER_EXP_END, ACCEPT_DOUBLE);
+	fsm_set(STATE_NUMBER_EXP_END, CLASS_DIGIT, STATE_NUMBER_EXP_END);
+
+	// minus sign or comments
+	fsm_row(STATE_MINUS, ACCEPT_MINUS);
+	fsm_set(STATE_MINUS, CLASS_MINUS, STATE_COMMENT);
+	fsm_row(STATE_LINE_COMMENT, STATE_LINE_COMMENT);
+	fsm_set(STATE_LINE_COMMENT, CLASS_NEWLINE, STATE_START);
+	fsm_set(STATE_LINE_COMMENT, CLASS_EOF, ACCEPT_EOF);
+	memcpy(transition[STATE_COMMENT], transition[STATE_LINE_COMMENT], CLASS_COUNT);
+	fsm_set(STATE_COMMENT, CLASS_LSQUARE, STATE_BLOCK_COMMENT_FIRST);
+	memcpy(transition[STATE_BLOCK_COMMENT_FIRST], transition[STATE_LINE_COMMENT], CLASS_COUNT);
+	fsm_set(STATE_BLOCK_COMMENT_FIRST, CLASS_LSQUARE, STATE_BLOCK_COMMENT);
+	fsm_row(STATE_BLOCK_COMMENT, STATE_BLOCK_COMMENT);
+	fsm_set(STATE_BLOCK_COMMENT, CLASS_RSQUARE, STATE_BLOCK_COMMENT_LEAVE);
+	fsm_set(STATE_BLOCK_COMMENT, CLASS_EOF, STATE_ERROR);
+	fsm_row(STATE_BLOCK_COMMENT_LEAVE, STATE_BLOCK_COMMENT);
+	fsm_set(STATE_BLOCK_COMMENT_LEAVE, CLASS_RSQUARE, STATE_START);
+	fsm_set(STATE_BLOCK_COMMENT_LEAVE, CLASS_EOF, STATE_ERROR);
+
+	// string literals, characters with ascii value lower than 32 are invalid
+	fsm_row(STATE_STRING, STATE_STRING);
+	fsm_set(STATE_STRING, CLASS_EOF, STATE_ERROR);
+	fsm_set(STATE_STRING, CLASS_INVALID, STATE_ERROR);
+	fsm_set(STATE_STRING, CLASS_NEWLINE, STATE_ERROR);
+	fsm_set(STATE_STRING, CLASS_CTRL_SPACE, STATE_ERROR);
+	fsm_set(STATE_STRING, CLASS_QUOTE, ACCEPT_STRING);
+	fsm_set(STATE_STRING, CLASS_BACKSLASH, STATE_STRING_ESCAPE);
+	memcpy(transition[STATE_STRING_BEGIN], transition[STATE_STRING], CLASS_COUNT);
+	memcpy(transition[STATE_STRING_ESCAPE_CHAR], transition[STATE_STRING], CLASS_COUNT);
+	memcpy(transition[STATE_STRING_ESCAPE_NUM_3], transition[STATE_STRING], CLASS_COUNT);
+	fsm_row(STATE_STRING_ESCAPE, STATE_ERROR);
+	fsm_set(STATE_STRING_ESCAPE, CLASS_T, STATE_STRING_ESCAPE_CHAR);
+	fsm_set(STATE_STRING_ESCAPE, CLASS_N, STATE_STRING_ESCAPE_CHAR);
+	fsm_set(STATE_STRING_ESCAPE, CLASS_QUOTE, STATE_STRING_ESCAPE_CHAR);
+	fsm_set(STATE_STRING_ESCAPE, CLASS_BACKSLASH, STATE_STRING_ESCAPE_CHAR);
+	fsm_set(STATE_STRING_ESCAPE, CLASS_DIGIT, STATE_STRING_ESCAPE_NUM_1);
+	fsm_row(STATE_STRING_ESCAPE_NUM_1, STATE_ERROR);
+	fsm_set(STATE_STRING_ESCAPE_NUM_1, CLASS_DIGIT, STATE_STRING_ESCAPE_NUM_2);
+	fsm_row(STATE_STRING_ESCAPE_NUM_2, STATE_ERROR);
+	fsm_set(STATE_STRING_ESCAPE_NUM_2, CLASS_DIGIT, STATE_STRING_ESCAPE_NUM_3);
+
+	fsm_ready = true;
+}
 
 // function to free allocated space for string when returning
 int free_and_return(string_t *s, int return_code) {
@@ -55,571 +340,565 @@ int free_and_return(string_t *s, int return_code) {
 }
 
 
-// function to check if string is keyword or it's just an identificator
-int check_keyword(string_t* s, token_t* token) 
+// perfect hash of keywords, computed from length, first and last character
+#define KEYWORD_HASH(s, len) \
+	(((len) * 2 + (unsigned char)(s)[0] + (unsigned char)(s)[(len) - 1] * 8) & 31)
+
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 8
+
+// keywords indexed by KEYWORD_HASH, empty slots have length 0
+static const struct {
+	const char *name;
+	unsigned int length;
+	keyword_t keyword;
+} keyword_table[32] = {
+	[0]  = {"do", 2, KW_DO},
+	[6]  = {"function", 8, KW_FUNCTION},
+	[7]  = {"integer", 7, KW_INTEGER},
+	[8]  = {"require", 7, KW_REQUIRE},
+	[9]  = {"while", 5, KW_WHILE},
+	[10] = {"number", 6, KW_NUMBER},
+	[11] = {"end", 3, KW_END},
+	[12] = {"then", 4, KW_THEN},
+	[14] = {"return", 6, KW_RETURN},
+	[19] = {"global", 6, KW_GLOBAL},
+	[20] = {"nil", 3, KW_NIL},
+	[21] = {"else", 4, KW_ELSE},
+	[22] = {"local", 5, KW_LOCAL},
+	[23] = {"string", 6, KW_STRING},
+	[29] = {"if", 2, KW_IF},
+};
+
+// function to check if string is keyword or it's just an identificator,
+// lexeme points into resident source, otherwise name was collected into s
+int check_keyword(string_t* s, const char *lexeme, token_t* token) 
 {
-	if (!strcmp(s->str,"do")) 
-		token->attribute.keyword = KW_DO;
-	else if (!strcmp(s->str,"else")) 
-		token->attribute.keyword = KW_ELSE;
-	else if (!strcmp(s->str,"end"))
-		token->attribute.keyword = KW_END;
-	else if (!strcmp(s->str,"function"))
-		token->attribute.keyword = KW_FUNCTION;
-	else if (!strcmp(s->str,"global"))
-		token->attribute.keyword = KW_GLOBAL;
-	else if (!strcmp(s->str,"if"))
-		token->attribute.keyword = KW_IF;
-	else if (!strcmp(s->str,"integer"))
-		token->attribute.keyword = KW_INTEGER;
-	else if (!strcmp(s->str,"local"))
-		token->attribute.keyword = KW_LOCAL;
-	else if (!strcmp(s->str,"nil"))
-		token->attribute.keyword = KW_NIL;
-	else if (!strcmp(s->str,"number"))
-		token->attribute.keyword = KW_NUMBER;
-	else if (!strcmp(s->str,"require"))
-		token->attribute.keyword = KW_REQUIRE;
-	else if (!strcmp(s->str,"return"))
-		token->attribute.keyword = KW_RETURN;
-	else if (!strcmp(s->str,"string"))
-		token->attribute.keyword = KW_STRING;
-	else if (!strcmp(s->str,"then"))
-		token->attribute.keyword = KW_THEN;
-	else if (!strcmp(s->str,"while"))
-		token->attribute.keyword = KW_WHILE;
-	else token->type = TOK_ID;
-
-	if (token->type != TOK_ID) {
-		token->type = TOK_KEYWORD;
+	const char *name = lexeme ? lexeme : s->str;
+	unsigned int len = lexeme ? (unsigned int)(source.cur - lexeme) : s->length;
+	token->type = TOK_ID;
+
+	// single lookup into keyword table and one compare decide the token type
+	if (len >= KEYWORD_MIN_LEN && len <= KEYWORD_MAX_LEN) {
+		unsigned int index = KEYWORD_HASH(name, len);
+		if (keyword_table[index].length == len &&
+				!memcmp(keyword_table[index].name, name, len)) {
+			token->attribute.keyword = keyword_table[index].keyword;
+			token->type = TOK_KEYWORD;
+		}
+	}
+
+	if (token->type == TOK_KEYWORD) {
 		return free_and_return(s, SUCCESS);
 	}
 
-	// init string attribute in token to save id
-	if (str_init(&token->attribute.s)) {
+	// identifier is interned, equal names share the same atom
+	token->attribute.id = atom_intern(name, len);
+	if (token->attribute.id == NULL) {
 		return free_and_return(s, ERROR_INTERNAL);
 	}
 
-	if (str_copy(s, &token->attribute.s)) {
-		return free_and_return(s, ERROR_INTERNAL); 
-
-	}
 	return free_and_return(s, SUCCESS);
 }
 
-// function to convert char* to int number
-int convert_to_int(token_t* token, string_t* s) 
+// convert digits of integer literal to 64-bit number, literal which doesn't
+// fit into int64_t is lexical error
+int convert_to_int(token_t* token, const char *num, size_t len)
 {
-	int result = 0;
-	char *ptr;
+	uint64_t result = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		unsigned digit = num[i] - '0';
+		if (result > ((uint64_t)INT64_MAX - digit) / 10) {
+			return ERROR_LEXICAL;
+		}
+		result = result * 10 + digit;
+	}
 
-	result = strtol(s->str, &ptr, 10);
-	
 	token->type = TOK_INT;
-	token->attribute.number = result;
-	return free_and_return(s, SUCCESS);
-
+	token->attribute.number = (int64_t)result;
+	return SUCCESS;
 }
 
-int convert_to_double(token_t* token, string_t* s)
-{
-	double result = 0;
-	char *ptr;
-
-	result = strtod(s->str, &ptr);
+// powers of ten which are exactly representable by double
+static const double pow10_exact[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
 
-	token->type = TOK_DECIMAL;
-	token->attribute.decimal = result;
-	return free_and_return(s, SUCCESS);
-}
+#define MANTISSA_DIGITS 19			// decimal digits which always fit uint64_t
+#define MANTISSA_EXACT (1ULL << 53)	// integers up to this are exact doubles
 
-
-
-int get_token(token_t *token) 
+// convert decimal literal (digits [. digits] [e [+-] digits]) to double,
+// number is exact when both mantissa and power of ten are exact doubles
+// (result is then correctly rounded single operation), otherwise strtod
+int convert_to_double(token_t* token, const char *num, size_t len)
 {
-	FILE *f = stdin;
-	string_t str;
+	uint64_t mantissa = 0;
+	int digits = 0;			// significant digits in mantissa
+	int exponent = 0;		// value is mantissa * 10^exponent
+	bool truncated = false;	// some non-zero digit didn't fit into mantissa
+	size_t i = 0;
+
+	for (; i < len && isdigit(num[i]); i++) {
+		if (digits < MANTISSA_DIGITS) {
+			mantissa = mantissa * 10 + (num[i] - '0');
+			digits += mantissa != 0;
+		} else {
+			exponent++;
+			truncated |= num[i] != '0';
+		}
+	}
 
-	if (str_init(&str)) {
-		return ERROR_INTERNAL;
+	if (i < len && num[i] == '.') {
+		for (i++; i < len && isdigit(num[i]); i++) {
+			if (digits < MANTISSA_DIGITS) {
+				mantissa = mantissa * 10 + (num[i] - '0');
+				digits += mantissa != 0;
+				exponent--;
+			} else {
+				truncated |= num[i] != '0';
+			}
+		}
 	}
 
-	int scanner_state = STATE_START;
-	token->type = TOK_NOTHING;
-	char c = '\0';
-	char escape_seq[3] = {'\0'};
-	
-	while(1) {
-		c = getc(f);
-		switch(scanner_state) {
-			case STATE_START:
-				if (isspace(c)) {
-					scanner_state = STATE_START;
-
-				} else if (c == '(') {
-					token->type = TOK_LBRACKET;
-					return free_and_return(&str, SUCCESS);
+	if (i < len) {
+		// skip 'e'
+		i++;
+		bool negative = num[i] == '-';
+		if (num[i] == '-' || num[i] == '+') {
+			i++;
+		}
+
+		int exp_value = 0;
+		for (; i < len; i++) {
+			// anything above this is zero or infinity anyway
+			if (exp_value < 100000) {
+				exp_value = exp_value * 10 + (num[i] - '0');
+			}
+		}
+		exponent += negative ? -exp_value : exp_value;
+	}
 
-				} else if (c == ')') {
-					token->type = TOK_RBRACKET;
-					return free_and_return(&str, SUCCESS);
+	double result;
+	if (!truncated && mantissa <= MANTISSA_EXACT && exponent >= -22 && exponent <= 22) {
+		result = exponent < 0 ? (double)mantissa / pow10_exact[-exponent]
+			: (double)mantissa * pow10_exact[exponent];
+	} else {
+		// rare slow path, strtod needs literal ended with '\0'
+		char buffer[64];
+		char *copy = len < sizeof(buffer) ? buffer : malloc(len + 1);
+		if (copy == NULL) {
+			return ERROR_INTERNAL;
+		}
+		memcpy(copy, num, len);
+		copy[len] = '\0';
+		result = strtod(copy, NULL);
+		if (copy != buffer) {
+			free(copy);
+		}
+	}
 
-				} else if (c == '+') {
-					token->type = TOK_PLUS;
-					return free_and_return(&str, SUCCESS);
+	token->type = TOK_DECIMAL;
+	token->attribute.decimal = result;
+	return SUCCESS;
+}
 
-				} else if (c == '#') {
-					token->type = TOK_LEN;
-					return free_and_return(&str, SUCCESS);
 
-				} else if (c == '*') {
-					token->type = TOK_MUL;
-					return free_and_return(&str, SUCCESS);
 
-				} else if (c == '/') {
-					scanner_state = STATE_DIV;
+// with GCC every state jumps directly to the code of next state (computed
+// goto), otherwise states are dispatched by switch in loop
+#if defined(__GNUC__) && !defined(SCANNER_NO_COMPUTED_GOTO)
+#define SCANNER_COMPUTED_GOTO
+#endif
+
+#ifdef SCANNER_COMPUTED_GOTO
+#define STATE(s) case s: label_##s
+#define DISPATCH() goto *state_label[state]
+#else
+#define STATE(s) case s
+#define DISPATCH() continue
+#endif
+
+// read next character and move to the next state (not wrapped in do-while,
+// continue has to reach the dispatch loop)
+#define NEXT_STATE()								\
+	{												\
+		c = SOURCE_GETC();							\
+		state = transition[state][CHAR_CLASS(c)];	\
+		DISPATCH();									\
+	}
 
-				} else if (c == '-') {
-					scanner_state = STATE_MINUS;
+// read characters while automaton stays in the same state, used by states
+// which don't store characters (whitespace, comments, viewed lexemes)
+#define SKIP_STATE()								\
+	{												\
+		unsigned int from = state;					\
+		do {										\
+			c = SOURCE_GETC();						\
+			state = transition[from][CHAR_CLASS(c)];\
+		} while (state == from);					\
+		DISPATCH();									\
+	}
 
-				} else if (c == '.') {
-					scanner_state = STATE_CONCAT;
+// find first character which isn't whitespace
+static inline const char *find_nonspace(const char *p, const char *end)
+{
+	// tokens are mostly separated by a single space, don't load vector then
+	if (p < end && *p != ' ' && (unsigned char)(*p - '\t') > '\r' - '\t') {
+		return p;
+	}
+#ifdef SCANNER_SIMD
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i ctrl_max = _mm_set1_epi8('\r' - '\t');
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		// '\t', '\n', '\v', '\f' and '\r' are consecutive (unsigned v - '\t' <= 4)
+		__m128i ctrl = _mm_sub_epi8(v, tab);
+		ctrl = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, ctrl_max), ctrl);
+		__m128i white = _mm_or_si128(ctrl, _mm_cmpeq_epi8(v, space));
+		int mask = _mm_movemask_epi8(white) ^ 0xffff;
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+	while (p < end && (*p == ' ' || (unsigned char)(*p - '\t') <= '\r' - '\t')) {
+		p++;
+	}
+	return p;
+}
 
-				} else if (c == '~') {
-					scanner_state = STATE_NOT_EQUAL;
+// find end of line comment (libc memchr is already vectorized)
+static inline const char *find_newline(const char *p, const char *end)
+{
+	const char *nl = memchr(p, '\n', end - p);
+	return nl ? nl : end;
+}
 
-				} else if (c == '>') {
-					scanner_state = STATE_GREAT;
+// find possible end of block comment
+static inline const char *find_rsquare(const char *p, const char *end)
+{
+	const char *rs = memchr(p, ']', end - p);
+	return rs ? rs : end;
+}
 
-				} else if (c == '<') {
-					scanner_state = STATE_LESS;
-				
-				} else if (c == '=') {
-					scanner_state = STATE_EQUAL;
+// find first character of string which isn't copied as it is (quote,
+// backslash, control character or byte above 127)
+static inline const char *find_string_special(const char *p, const char *end)
+{
+#ifdef SCANNER_SIMD
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i space = _mm_set1_epi8(' ');
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		// signed compare, bytes above 127 are negative and stop the scan too
+		__m128i special = _mm_or_si128(_mm_cmplt_epi8(v, space),
+				_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+		int mask = _mm_movemask_epi8(special);
+		if (mask) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#endif
+	while (p < end) {
+		unsigned char b = *p;
+		if (b < ' ' || b > 127 || b == '"' || b == '\\') {
+			break;
+		}
+		p++;
+	}
+	return p;
+}
 
-				} else if (c == ':') {
-					token->type = TOK_COLON;
-					return free_and_return(&str, SUCCESS);
-				
-				} else if (c == ',') {
-					token->type = TOK_COMMA;
-					return free_and_return(&str, SUCCESS);
+// move input to the first character found by given function, characters
+// before it would only loop the automaton in the same state
+#ifdef SOURCE_STDIO
+#define FAST_SKIP(find)
+#else
+#define FAST_SKIP(find) source.cur = find(source.cur, source.end)
+#endif
 
-				} else if (c == EOF) {
-					token->type = TOK_EOF;
-					return free_and_return(&str, SUCCESS);
+int get_token(token_t *token) 
+{
+	// lexeme which cannot be viewed in source is collected in stack buffer,
+	// it's allocated only when it's longer or it's passed in token (string)
+	STR_BUFFERED(str);
+	// start of identifier/string in resident source (zero-copy lexeme)
+	const char *lexeme = NULL;
 
-				} else if (isalpha(c) || c == '_') {
-					
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_ID_OR_KEYWORD;
+	unsigned int state = STATE_START;
+	token->type = TOK_NOTHING;
+	int c = '\0';
+	// three digits of numeric escape sequence ended with '\0' for strtol
+	char escape_seq[4] = {'\0'};
 
-				} else if (isdigit(c)) {
-					
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_NUMBER;
-				
-				} else if (c == '"') {
-					scanner_state = STATE_STRING;
+	if (!fsm_ready) {
+		fsm_init();
+	}
 
-				} else {
+#ifdef SCANNER_COMPUTED_GOTO
+	static const void *state_label[STATE_ALL_COUNT] = {
+		&&label_STATE_START,
+		&&label_STATE_ID_BEGIN,
+		&&label_STATE_ID,
+		&&label_STATE_MINUS,
+		&&label_STATE_COMMENT,
+		&&label_STATE_LINE_COMMENT,
+		&&label_STATE_BLOCK_COMMENT_FIRST,
+		&&label_STATE_BLOCK_COMMENT,
+		&&label_STATE_BLOCK_COMMENT_LEAVE,
+		&&label_STATE_DIV,
+		&&label_STATE_EQUAL,
+		&&label_STATE_LESS,
+		&&label_STATE_GREAT,
+		&&label_STATE_NOT_EQUAL,
+		&&label_STATE_CONCAT,
+		&&label_STATE_NUMBER,
+		&&label_STATE_NUMBER_POINT,
+		&&label_STATE_NUMBER_DEC,
+		&&label_STATE_NUMBER_E,
+		&&label_STATE_NUMBER_EXP_SIGN,
+		&&label_STATE_NUMBER_EXP_END,
+		&&label_STATE_STRING_BEGIN,
+		&&label_STATE_STRING,
+		&&label_STATE_STRING_ESCAPE,
+		&&label_STATE_STRING_ESCAPE_CHAR,
+		&&label_STATE_STRING_ESCAPE_NUM_1,
+		&&label_STATE_STRING_ESCAPE_NUM_2,
+		&&label_STATE_STRING_ESCAPE_NUM_3,
+		[ACCEPT_EOF ... ACCEPT_EQ] = &&label_ACCEPT_EOF,
+		&&label_ACCEPT_ID,
+		&&label_ACCEPT_INT,
+		&&label_ACCEPT_DOUBLE,
+		&&label_ACCEPT_STRING,
+		&&label_STATE_ERROR,
+		&&label_STATE_ERROR_UNGET,
+	};
+#endif
+
+	token->offset = SOURCE_TELL();
+	c = SOURCE_GETC();
+	state = transition[STATE_START][CHAR_CLASS(c)];
+
+	while (1) {
+		// code of each state is executed when the state is entered with c
+		switch (state) {
+			// whitespace, operators and comments don't store anything
+			// token (or comment) begins with first character after whitespace,
+			// only its offset is stored, line is resolved by source_position()
+			STATE(STATE_START):
+				FAST_SKIP(find_nonspace);
+				do {
+					token->offset = SOURCE_TELL();
+					c = SOURCE_GETC();
+					state = transition[STATE_START][CHAR_CLASS(c)];
+				} while (state == STATE_START);
+				DISPATCH();
+
+			STATE(STATE_LINE_COMMENT):
+				FAST_SKIP(find_newline);
+				SKIP_STATE();
+
+			STATE(STATE_BLOCK_COMMENT):
+				FAST_SKIP(find_rsquare);
+				SKIP_STATE();
+
+			STATE(STATE_MINUS):
+			STATE(STATE_COMMENT):
+			STATE(STATE_BLOCK_COMMENT_FIRST):
+			STATE(STATE_BLOCK_COMMENT_LEAVE):
+			STATE(STATE_DIV):
+			STATE(STATE_EQUAL):
+			STATE(STATE_LESS):
+			STATE(STATE_GREAT):
+			STATE(STATE_NOT_EQUAL):
+			STATE(STATE_CONCAT):
+				SKIP_STATE();
 
-					return free_and_return(&str, ERROR_LEXICAL);
+			// state for id and keyword proccessing
+			STATE(STATE_ID_BEGIN):
+				if (SOURCE_RESIDENT()) {
+					lexeme = source.cur - 1;
+				} else if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
+				NEXT_STATE();
 
-				break; // end of START_STATE
-			
-			case STATE_DIV:
-				if (c == '/') {
-					token->type = TOK_INT_DIV;
-
-				} else {
-					ungetc(c, f);
-					token->type = TOK_DIV;
-
+			STATE(STATE_ID):
+				if (lexeme) {
+					SKIP_STATE();
+				} else if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
-
-				return free_and_return(&str, SUCCESS);
-        
-				break;
-
-			case STATE_CONCAT:
-				if (c == '.') {
-					token->type= TOK_CONCAT;
-					return free_and_return(&str, SUCCESS);
-
-				} else {
-					ungetc(c, f);
-					return free_and_return(&str, ERROR_LEXICAL);
-				
+				NEXT_STATE();
+
+			// states for number proccessing, digits are parsed in place when
+			// source is resident
+			STATE(STATE_NUMBER):
+				if (SOURCE_RESIDENT()) {
+					if (lexeme == NULL) {
+						lexeme = source.cur - 1;
+					}
+					SKIP_STATE();
 				}
-				break;
-
-			case STATE_NOT_EQUAL:
-				if (c == '=') {
-					token->type = TOK_NEQ;
-					return free_and_return(&str, SUCCESS);
-				
-				} else {
-					ungetc(c, f);
-					return free_and_return(&str, ERROR_LEXICAL);
+				if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
-				break;
-
-			case STATE_GREAT:
-				if (c == '=') {
-					token->type = TOK_GR_EQ;
-					
-				} else {
-					ungetc(c, f);
-					token->type = TOK_GR;
+				NEXT_STATE();
+
+			STATE(STATE_NUMBER_POINT):
+			STATE(STATE_NUMBER_DEC):
+			STATE(STATE_NUMBER_E):
+			STATE(STATE_NUMBER_EXP_SIGN):
+			STATE(STATE_NUMBER_EXP_END):
+				if (lexeme) {
+					SKIP_STATE();
 				}
-
-				return free_and_return(&str, SUCCESS);
-
-				break;
-
-			case STATE_LESS:
-				if (c == '=') {
-					token->type = TOK_LES_EQ;
-
-				} else {
-					ungetc(c, f);
-					token->type = TOK_LES;
+				if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
-        
-				return free_and_return(&str, SUCCESS);
-
-				break;
-
-			case STATE_EQUAL:
-				if (c == '=') {
-					token->type = TOK_EQ;
-					
-				} else {
-					ungetc(c, f);
-					token->type = TOK_ASSIGN;
+				NEXT_STATE();
 
+			// states for string literal
+			STATE(STATE_STRING_BEGIN):
+				if (SOURCE_RESIDENT()) {
+					lexeme = source.cur;
 				}
-
-				return free_and_return(&str, SUCCESS);
-
-				break;
-
-			// state for id and keyword proccessing
-			case STATE_ID_OR_KEYWORD:
-				if (isalnum(c) || c == '_') {
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-
-				} else {
-					ungetc(c, f);
-					return check_keyword(&str, token);
-
+				NEXT_STATE();
+
+			STATE(STATE_STRING):
+				if (lexeme) {
+					FAST_SKIP(find_string_special);
+					SKIP_STATE();
+				} else if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
-				break;
-
-			// states for number proccessing
-			case STATE_NUMBER:
-				if (isdigit(c)) {
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
+				NEXT_STATE();
 
-				} else if (c == '.') {
-					scanner_state = STATE_NUMBER_POINT;
-					if (str_add_char(&str, c)) {
+			STATE(STATE_STRING_ESCAPE):
+				// escaped string has to be materialized, copy characters read so far
+				if (lexeme) {
+					if (str_insert_n(&str, lexeme, source.cur - 1 - lexeme)) {
 						return free_and_return(&str, ERROR_INTERNAL);
 					}
-
-				} else if (c == 'e' || c == 'E') {
-					scanner_state = STATE_NUMBER_E;
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-
-				} else {
-					ungetc(c, f);
-
-					return convert_to_int(token, &str);
-
+					lexeme = NULL;
 				}
-				break;
-
-			case STATE_NUMBER_POINT:
-				if (isdigit(c)) {
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);;
-					}
-					scanner_state = STATE_NUMBER_DEC;
+				NEXT_STATE();
 
-				} else {
-					ungetc(c, f);
-					return free_and_return(&str, ERROR_LEXICAL);
+			STATE(STATE_STRING_ESCAPE_CHAR):
+				if (c == 't') {
+					c = '\t';
+				} else if (c == 'n') {
+					c = '\n';
 				}
 
-				break;
-
-			case STATE_NUMBER_DEC:
-				if (isdigit(c)) {
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-
-				} else if (c == 'E' || c == 'e') {
-					scanner_state = STATE_NUMBER_E;
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-
-				} else {
-					ungetc(c, f);
-
-					return convert_to_double(token, &str);
-
+				if (str_add_char(&str, c)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
+				NEXT_STATE();
 
-				break;
+			STATE(STATE_STRING_ESCAPE_NUM_1):
+				escape_seq[0] = c;
+				NEXT_STATE();
 
-			case STATE_NUMBER_E:
-				if (isdigit(c)) {
-					scanner_state = STATE_NUMBER_EXP_END;
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					
-				} else if (c == '+' || c == '-') {
-					scanner_state = STATE_NUMBER_EXP_SIGN;
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
+			STATE(STATE_STRING_ESCAPE_NUM_2):
+				escape_seq[1] = c;
+				NEXT_STATE();
 
-				} else {
-					ungetc(c, f);
-					return free_and_return(&str, ERROR_LEXICAL);
-				}
-				
-				break;
-
-			case STATE_NUMBER_EXP_SIGN:
-				if (isdigit(c)) {
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
+			STATE(STATE_STRING_ESCAPE_NUM_3):
+				escape_seq[2] = c;
+				{
+					char *ptr;
+					int result = strtol(escape_seq, &ptr, 10);
+					// check if escape sequace character is between 1 and 255
+					// otherwise it's invalid character
+					if (result < 1 || result > 255) {
+						return free_and_return(&str, ERROR_LEXICAL);
 					}
-					scanner_state = STATE_NUMBER_EXP_END;
-
-				} else {
-					ungetc(c, f);
-					return free_and_return(&str, ERROR_LEXICAL);
-				}
 
-				break;
-
-			case STATE_NUMBER_EXP_END:
-				if (isdigit(c)) {
-					if (str_add_char(&str, c)) {
+					if (str_add_char(&str, (char) result)) {
 						return free_and_return(&str, ERROR_INTERNAL);
 					}
-
-				} else {
-					ungetc(c, f);
-
-					return convert_to_double(token, &str);
-
-				
-				}
-
-				break;
-
-			// states for commentary or minus sign (-)
-			case STATE_MINUS:
-				if (c == '-') {
-					scanner_state = STATE_COMMENT;
-
-				} else {
-					token->type = TOK_MINUS;
-					ungetc(c, f);
-
-					return free_and_return(&str, SUCCESS);
-
 				}
-				break;
-
-			case STATE_COMMENT:
-				if (c == '[') {
-					scanner_state = STATE_BLOCK_COMMENT_FIRST;
-
-				} else if (c == '\n') {
-					scanner_state = STATE_START;
-
-				} else {
-					scanner_state = STATE_LINE_COMMENT;
-
+				NEXT_STATE();
+
+			// final states
+			STATE(ACCEPT_EOF):
+			case ACCEPT_LBRACKET:
+			case ACCEPT_RBRACKET:
+			case ACCEPT_PLUS:
+			case ACCEPT_MINUS:
+			case ACCEPT_LEN:
+			case ACCEPT_MUL:
+			case ACCEPT_DIV:
+			case ACCEPT_INT_DIV:
+			case ACCEPT_COLON:
+			case ACCEPT_COMMA:
+			case ACCEPT_CONCAT:
+			case ACCEPT_NEQ:
+			case ACCEPT_LES:
+			case ACCEPT_LES_EQ:
+			case ACCEPT_GR:
+			case ACCEPT_GR_EQ:
+			case ACCEPT_ASSIGN:
+			case ACCEPT_EQ:
+				if (accept_table[state].unget) {
+					SOURCE_UNGETC(c);
 				}
-				break;
+				token->type = accept_table[state].type;
+				return free_and_return(&str, SUCCESS);
 
-			case STATE_LINE_COMMENT:
-				if (c == '\n') {
-					scanner_state = STATE_START;
+			STATE(ACCEPT_ID):
+				SOURCE_UNGETC(c);
+				return check_keyword(&str, lexeme, token);
 
-				} else if (c == EOF) {
-					ungetc(c, f);
-					scanner_state = STATE_START;
+			STATE(ACCEPT_INT):
+				SOURCE_UNGETC(c);
+				if (lexeme) {
+					return convert_to_int(token, lexeme, source.cur - lexeme);
 				}
-				break;
-
-			case STATE_BLOCK_COMMENT_FIRST:
-				if (c == '[') {
-					scanner_state = STATE_BLOCK_COMMENT;
-				
-				} else if (c == '\n') {
-					scanner_state = STATE_START;
-
-				} else if (c != '\n') {
-					scanner_state = STATE_LINE_COMMENT;
-					ungetc(c, f);
+				return free_and_return(&str, convert_to_int(token, str.str, str.length));
 
+			STATE(ACCEPT_DOUBLE):
+				SOURCE_UNGETC(c);
+				if (lexeme) {
+					return convert_to_double(token, lexeme, source.cur - lexeme);
 				}
-				break;
-
-			case STATE_BLOCK_COMMENT:
-				if (c == ']') {
-					scanner_state = STATE_BLOCK_COMMENT_LEAVE;
-				
-				} else if (c == EOF) {
-					return free_and_return(&str, ERROR_LEXICAL);
-				} 
-				break;
-
-			case STATE_BLOCK_COMMENT_LEAVE:
-				if (c == ']') {
-					scanner_state = STATE_START; 
-
-				}  else if (c == EOF) {
-					return free_and_return(&str, ERROR_LEXICAL);
-
-				} else {
-					scanner_state = STATE_BLOCK_COMMENT;
-				}
-				break;
-
-			// state for string literal
-			case STATE_STRING:
-				// cant write in string literal char with ascii value lower than 32
-				if (c < 32) {
-
-					return free_and_return(&str, ERROR_LEXICAL);
-
-
-				} else if (c == '"') {
-					// inicialize token string attribute
-
-
-					if (str_init(&token->attribute.s)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
+				return free_and_return(&str, convert_to_double(token, str.str, str.length));
 
-					if (str_copy(&str, &token->attribute.s)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
+			STATE(ACCEPT_STRING):
+				token->type = TOK_STRING;
 
-					token->type = TOK_STRING;
+				if (lexeme) {
+					// string without escape sequences is a view into source
+					token->attribute.s = str_view(lexeme, source.cur - 1 - lexeme);
 					return free_and_return(&str, SUCCESS);
-
-
-				} else if (c == '\\') {
-					scanner_state = STATE_STRING_ESCAPE;
-
-				} else {
-
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
 				}
-				break;
-
-			case STATE_STRING_ESCAPE:
-				if (c == 't') {
-					c = '\t';
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_STRING;
-
-				} else if (c == 'n') {
-					c = '\n';
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_STRING;
-
-				} else if (c == '"') {
-					c = '"';
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_STRING;
-
-				} else if (c == '\\') {
-					c = '\\';
-					if (str_add_char(&str, c)) {
-						return free_and_return(&str, ERROR_INTERNAL);
-					}
-					scanner_state = STATE_STRING;
-					
-				} else if (isdigit(c)) {
-					escape_seq[0] = c;
-					scanner_state = STATE_STRING_ESCAPE_NUM_1;
-
-				} else {
-					return free_and_return(&str, ERROR_LEXICAL);
 
+				// pass collected string to token, empty string needs no memory
+				if (str.length == 0) {
+					token->attribute.s = str_view("", 0);
+					return SUCCESS;
 				}
-				break;
-
-			case STATE_STRING_ESCAPE_NUM_1:
-				if (isdigit(c)) {
-					escape_seq[1] = c;
-					scanner_state = STATE_STRING_ESCAPE_NUM_2;
-
-				} else {
-					return free_and_return(&str, ERROR_LEXICAL);
-					
+				if (str_own(&str)) {
+					return free_and_return(&str, ERROR_INTERNAL);
 				}
-				break;
-
-			case STATE_STRING_ESCAPE_NUM_2:
-				if (isdigit(c)) {
-					escape_seq[2] = c;
-					scanner_state = STATE_STRING;
-					
-					char *ptr;
-					int result = strtol(escape_seq, &ptr, 10);
-					// check if escape sequace character is between 1 and 255
-					// otherwise it's invalid character
-					if (result >= 1 && result <= 255) {
-						c = (char) result;
-            
-						if (str_add_char(&str, c)) {
-							return free_and_return(&str, ERROR_INTERNAL);
-						}
-
-					} else {
-						return free_and_return(&str, ERROR_LEXICAL);
-
-					}
-				} else {
-					return free_and_return(&str, ERROR_LEXICAL);
+				token->attribute.s = str;
+				return SUCCESS;
 
+			STATE(STATE_ERROR_UNGET):
+				SOURCE_UNGETC(c);
+				return free_and_return(&str, ERROR_LEXICAL);
 
-				}
-				break;
+			STATE(STATE_ERROR):
+			default:
+				return free_and_return(&str, ERROR_LEXICAL);
 
-		} // case
-	} // while loop 
+		} // switch
+	} // while loop
 }
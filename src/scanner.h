@@ -14,7 +14,9 @@
 #ifndef _SCANNER_H_
 #define _SCANNER_H_
 
+#include <stddef.h>
 #include "str.h"
+#include "atom.h"
 
 typedef enum {
 	TOK_ID,				// Identifier
@@ -69,19 +71,21 @@ typedef enum {
 } keyword_t;
 
 typedef union {
-	string_t s;
+	string_t s;			// TOK_STRING
+	atom_t *id;			// TOK_ID
 	double decimal;
-	int number;
+	int64_t number;		// TOK_INT
 	keyword_t keyword;
 } token_attribute_t;
 
 typedef struct {
 	token_attribute_t attribute;
 	token_type_t type;
+	size_t offset;		// offset of first character in source (source_position())
 } token_t;
 
 /**
- * @brief Main scanner function, scans stdin and sends further corresponding token
+ * @brief Main scanner function, scans source (stdin by default) and sends further corresponding token
  *
  * @param token Pointer to token, where all important info is stored
  *
@@ -0,0 +1,220 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file source.c
+ *
+ * @brief Implementation of input layer for scanner
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+#include "error.h"
+
+source_t source = {NULL, NULL, NULL, 0, 0, -1, SRC_NONE, false};
+
+// offsets of line beginnings (except first line), scanner doesn't count
+// lines, newlines are searched only when a position is requested
+static struct {
+    size_t *start;      // start[i] is offset of line i + 2
+    size_t count;
+    size_t capacity;
+    size_t indexed;     // input before this offset is already indexed
+} lines = {NULL, 0, 0, 0};
+
+/**
+ * @brief Add newlines of data in buffer up to offset to the line index
+ */
+static int source_index(size_t offset)
+{
+    size_t buffered = source.offset + (source.end - source.data);
+    if (offset > buffered) {
+        offset = buffered;
+    }
+    if (lines.indexed >= offset || lines.indexed < source.offset) {
+        return SUCCESS;
+    }
+
+    const char *p = source.data + (lines.indexed - source.offset);
+    const char *end = source.data + (offset - source.offset);
+
+    // libc memchr is vectorized
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        if (lines.count == lines.capacity) {
+            size_t capacity = lines.capacity ? lines.capacity * 2 : 1024;
+            size_t *start = realloc(lines.start, capacity * sizeof(*start));
+            if (start == NULL) {
+                return ERROR_INTERNAL;
+            }
+            lines.start = start;
+            lines.capacity = capacity;
+        }
+
+        p++;
+        lines.start[lines.count++] = source.offset + (p - source.data);
+    }
+    lines.indexed = offset;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Map whole regular file into memory
+ */
+static int source_map(int fd, size_t size)
+{
+    // stdin could have been partly read already, continue from current position
+    off_t start = lseek(fd, 0, SEEK_CUR);
+    if (start < 0 || (size_t)start > size) {
+        start = 0;
+    }
+
+    source.mode = SRC_MMAP;
+    source.size = size;
+    source.offset = 0;
+
+    // empty file cannot be mapped
+    if (size == 0) {
+        source.data = NULL;
+        source.cur = source.end = NULL;
+        return SUCCESS;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return ERROR_INTERNAL;
+    }
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+
+    source.data = map;
+    source.cur = source.data + start;
+    source.end = source.data + size;
+
+    return SUCCESS;
+}
+
+int source_open(int fd)
+{
+    struct stat st;
+
+    source.fd = fd;
+    source.eof = false;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (source_map(fd, st.st_size) == SUCCESS) {
+            return SUCCESS;
+        }
+    }
+
+    // fallback for pipes (and files that could not be mapped)
+    source.data = malloc(SOURCE_CHUNK_SIZE);
+    if (source.data == NULL) {
+        source.mode = SRC_NONE;
+        return ERROR_INTERNAL;
+    }
+
+    source.mode = SRC_STREAM;
+    source.size = SOURCE_CHUNK_SIZE;
+    source.offset = 0;
+    source.cur = source.end = source.data;
+
+    return SUCCESS;
+}
+
+int source_refill()
+{
+    if (source.mode == SRC_NONE) {
+        if (source_open(STDIN_FILENO)) {
+            return EOF;
+        }
+        if (source.cur < source.end) {
+            return (unsigned char)*source.cur++;
+        }
+    }
+
+    // mapped file has no more data
+    if (source.mode != SRC_STREAM || source.eof) {
+        return EOF;
+    }
+
+    // whole chunk was consumed, index it before it's overwritten by the next one
+    if (source_index(SOURCE_TELL())) {
+        return EOF;
+    }
+
+    ssize_t len;
+    do {
+        len = read(source.fd, source.data, source.size);
+    } while (len < 0 && errno == EINTR);
+
+    if (len <= 0) {
+        source.eof = true;
+        return EOF;
+    }
+
+    source.offset += source.end - source.data;
+    source.cur = source.data;
+    source.end = source.data + len;
+
+    return (unsigned char)*source.cur++;
+}
+
+size_t source_tell()
+{
+    return source.offset + (source.cur - source.data);
+}
+
+int source_position(size_t offset, source_pos_t *pos)
+{
+    if (source.mode == SRC_NONE || source_index(offset)) {
+        return ERROR_INTERNAL;
+    }
+
+    // number of lines starting before or at offset
+    size_t low = 0, high = lines.count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (lines.start[mid] <= offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    pos->line = low + 1;
+    pos->column = offset - (low ? lines.start[low - 1] : 0) + 1;
+
+    return SUCCESS;
+}
+
+void source_close()
+{
+    free(lines.start);
+    lines.start = NULL;
+    lines.count = lines.capacity = lines.indexed = 0;
+
+    if (source.mode == SRC_MMAP && source.data != NULL) {
+        munmap(source.data, source.size);
+    } else if (source.mode == SRC_STREAM) {
+        free(source.data);
+    }
+
+    source.data = NULL;
+    source.cur = source.end = NULL;
+    source.size = 0;
+    source.offset = 0;
+    source.fd = -1;
+    source.mode = SRC_NONE;
+    source.eof = false;
+}
@@ -0,0 +1,117 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file source.h
+ *
+ * @brief Input layer for scanner (memory mapped file or chunked stream)
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _SOURCE_H_
+#define _SOURCE_H_
+
+#include <stdio.h>      // EOF
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SOURCE_CHUNK_SIZE 65536     // size of single read() when streaming
+
+typedef enum {
+    SRC_NONE,       // source was not opened yet
+    SRC_MMAP,       // whole regular file is mapped into memory
+    SRC_STREAM,     // pipe/terminal is read in chunks
+} source_mode_t;
+
+/**
+ * @brief Source code which is being scanned
+ */
+typedef struct source {
+    const char *cur;    // next character to be scanned
+    const char *end;    // end of valid data in buffer
+    char *data;         // mapped file or chunk buffer
+    size_t size;        // size of mapping or chunk buffer
+    size_t offset;      // offset of data[0] from the beginning of input
+    int fd;             // file descriptor of input
+    source_mode_t mode;
+    bool eof;           // stream reached end of input
+} source_t;
+
+extern source_t source;
+
+/**
+ * @brief Line and column (both from 1) of position in source
+ */
+typedef struct source_pos {
+    size_t line;
+    size_t column;
+} source_pos_t;
+
+/**
+ * @brief Open source from file descriptor, regular files are mapped into
+ *  memory, everything else is read in SOURCE_CHUNK_SIZE chunks
+ *
+ * @param fd File descriptor of input
+ *
+ * @return SUCCESS (0) if successful, otherwise ERROR_INTERNAL
+ */
+int source_open(int fd);
+
+/**
+ * @brief Slow path of SOURCE_GETC, open stdin if needed and read next chunk
+ *
+ * @return Next character of input or EOF
+ */
+int source_refill();
+
+/**
+ * @brief Get number of bytes consumed from the beginning of input
+ */
+size_t source_tell();
+
+/**
+ * @brief Resolve byte offset to line and column, line index is built only
+ *  when it's needed (streamed chunks are indexed before they are replaced)
+ *
+ * @param offset Offset from the beginning of input (see source_tell())
+ * @param pos Resolved position
+ *
+ * @return SUCCESS (0) if successful, otherwise ERROR_INTERNAL
+ */
+int source_position(size_t offset, source_pos_t *pos);
+
+/**
+ * @brief Unmap/free source and line index, set source to initial state
+ */
+void source_close();
+
+#ifdef SOURCE_STDIO
+// legacy input through stdio, kept to compare scanner throughput
+#define SOURCE_GETC() getc(stdin)
+#define SOURCE_UNGETC(c) ungetc((c), stdin)
+#define SOURCE_RESIDENT() 0
+#define SOURCE_TELL() 0
+#else
+// whole input stays in memory until source_close(), so lexemes can be
+// viewed in place instead of being copied
+#define SOURCE_RESIDENT() (source.mode == SRC_MMAP)
+
+// offset of next character from the beginning of input
+#define SOURCE_TELL() (source.offset + (size_t)(source.cur - source.data))
+
+// get next character of input, buffer is refilled only when it's empty
+#define SOURCE_GETC() \
+    (source.cur < source.end ? (unsigned char)*source.cur++ : source_refill())
+
+// return last character back to input (lookahead of one character)
+#define SOURCE_UNGETC(c)        \
+do {                            \
+    if ((c) != EOF)             \
+        source.cur--;           \
+} while (0)
+#endif
+
+#endif // _SOURCE_H_
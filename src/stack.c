@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include "expression.h"
 #include "stack.h"
+#include "arena.h"
 
 void stack_init(stack_t *stack)
 {
@@ -28,7 +29,7 @@ int stack_is_empty(stack_t *stack)
 
 int stack_push(stack_t *stack, int value)
 {
-    stack_item_t *new = malloc(sizeof(stack_item_t));
+    stack_item_t *new = arena_alloc(&arena, sizeof(stack_item_t));
     if (new == NULL) {
         return 1;
     }
@@ -45,7 +46,7 @@ int stack_push_above_term(stack_t *stack, int value)
     stack_item_t *curr = stack->top;
     stack_item_t *prev = NULL;
 
-    stack_item_t *new = malloc(sizeof(stack_item_t));
+    stack_item_t *new = arena_alloc(&arena, sizeof(stack_item_t));
     if (new == NULL) {
         return 1;
     }
@@ -83,7 +84,7 @@ int stack_pop(stack_t *stack)
 
     stack_item_t *pop = stack->top;
     stack->top = pop->next;
-    free(pop);
+    arena_free(&arena, pop, sizeof(stack_item_t));
 
     return 0;
 }
@@ -11,7 +11,6 @@
  * @author Adam Zvara
  */
 
-#include <stdio.h>	// snprintf
 #include <stdlib.h>
 #include <string.h>
 #include "str.h"
@@ -19,6 +18,44 @@
 
 #define STR_LENGTH_INC 16 	// Length of the string when inicialized
 
+// size of allocated (or borrowed) space for characters
+#define STR_CAPACITY(s) ((s)->alloc_size & ~STR_BORROWED)
+
+int str_reserve(string_t *s, unsigned int length)
+{
+	unsigned int capacity = STR_CAPACITY(s);
+	if (length < capacity) {
+		return SUCCESS;
+	}
+
+	unsigned int new_capacity = capacity > STR_LENGTH_INC ? capacity : STR_LENGTH_INC;
+	while (new_capacity <= length) {
+		new_capacity *= 2;
+	}
+
+	char *str;
+	if (s->alloc_size == 0 || (s->alloc_size & STR_BORROWED)) {
+		str = malloc(new_capacity);
+		if (str == NULL) {
+			return ERROR_INTERNAL;
+		}
+		if (s->length) {
+			memcpy(str, s->str, s->length);
+		}
+		str[s->length] = '\0';
+	} else {
+		str = realloc(s->str, new_capacity);
+		if (str == NULL) {
+			return ERROR_INTERNAL;
+		}
+	}
+
+	s->str = str;
+	s->alloc_size = new_capacity;
+
+	return SUCCESS;
+}
+
 int str_init(string_t* s)
 {
 	s->str = malloc(STR_LENGTH_INC);
@@ -33,20 +70,43 @@ int str_init(string_t* s)
 	return SUCCESS;
 }
 
-void str_free(string_t* s)
+void str_init_buffer(string_t *s, char *buffer, unsigned int size)
+{
+	s->str = buffer;
+	s->length = 0;
+	s->alloc_size = size | STR_BORROWED;
+	s->str[0] = '\0';
+}
+
+int str_own(string_t *s)
 {
-	free(s->str);
+	if (s->alloc_size != 0 && !(s->alloc_size & STR_BORROWED)) {
+		return SUCCESS;
+	}
+
+	// capacity of borrowed buffer is forgotten, so string has to be moved
+	s->alloc_size = STR_BORROWED;
+	return str_reserve(s, s->length);
+}
 
+string_t str_view(const char *str, unsigned int length)
+{
+	string_t view = {(char *)str, length, 0};
+	return view;
+}
+
+void str_free(string_t* s)
+{
+	// views and strings in caller's buffer do not own their characters
+	if (s->alloc_size && !(s->alloc_size & STR_BORROWED)) {
+		free(s->str);
+	}
 }
 
 int str_add_char(string_t* s, char c)
 {
-	if (s->length + 1 >= s->alloc_size) {
-		s->str = realloc(s->str, s->length + STR_LENGTH_INC);
-		if (!s->str) {
-			return ERROR_INTERNAL;
-		}
-		s->alloc_size += STR_LENGTH_INC;
+	if (s->length + 1 >= STR_CAPACITY(s) && str_reserve(s, s->length + 1)) {
+		return ERROR_INTERNAL;
 	}
 	s->str[s->length++] = c;
 	s->str[s->length] = '\0';
@@ -60,39 +120,94 @@ int str_insert(string_t *str, char* to_insert)
 		return 0;
 	}
 
-	size_t insert_len = strlen(to_insert);
+	return str_insert_n(str, to_insert, strlen(to_insert));
+}
 
-	// expand string until to_insert can be inserted
-	while (str->length + insert_len >= str->alloc_size) {
-		str->str = realloc(str->str, str->alloc_size + STR_LENGTH_INC);
-		if (str->str == NULL) {
-			return ERROR_INTERNAL;
-		}
-		str->alloc_size += STR_LENGTH_INC;
+int str_insert_n(string_t *str, const char* to_insert, unsigned int insert_len)
+{
+	// characters are appended at known length, string is never rescanned
+	if (str_reserve(str, str->length + insert_len)) {
+		return ERROR_INTERNAL;
 	}
 
-	strcat(str->str, to_insert);
+	memcpy(str->str + str->length, to_insert, insert_len);
 	str->length += insert_len;
+	str->str[str->length] = '\0';
 
 	return SUCCESS;
 }
 
-int str_insert_int(string_t* str, int num)
+int str_insert_int(string_t* str, int64_t num)
 {
-	// string into which num will be converted
-	char num_str[12] = {0};
-	snprintf(num_str, 12, "%d", num);
+	// digits are written from the end of buffer (sign and 19 digits)
+	char digits[20];
+	unsigned int i = sizeof(digits);
+	uint64_t value = num < 0 ? -(uint64_t)num : (uint64_t)num;
+
+	do {
+		digits[--i] = '0' + value % 10;
+		value /= 10;
+	} while (value);
 
-	return str_insert(str, num_str);
+	if (num < 0) {
+		digits[--i] = '-';
+	}
+
+	return str_insert_n(str, digits + i, sizeof(digits) - i);
 }
 
 int str_insert_double(string_t* str, double num)
 {
-	// string into which num will be converted
-	char num_str[30] = {0};
-	snprintf(num_str, 30, "%a", num);
+	// same output as printf("%a"), e.g. 0x1.8p+1, 0x0.0000000000001p-1022
+	static const char hex[] = "0123456789abcdef";
+	char out[32];
+	unsigned int n = 0;
+
+	uint64_t bits;
+	memcpy(&bits, &num, sizeof(bits));
+	int exponent = (bits >> 52) & 0x7ff;
+	uint64_t mantissa = bits & ((1ULL << 52) - 1);
 
-	return str_insert(str, num_str);
+	if (bits >> 63) {
+		out[n++] = '-';
+	}
+
+	if (exponent == 0x7ff) {
+		memcpy(out + n, mantissa ? "nan" : "inf", 3);
+		return str_insert_n(str, out, n + 3);
+	}
+
+	out[n++] = '0';
+	out[n++] = 'x';
+	// normal numbers have implicit leading 1, subnormals (and zero) 0
+	out[n++] = exponent ? '1' : '0';
+
+	if (mantissa) {
+		out[n++] = '.';
+		while (mantissa) {
+			out[n++] = hex[mantissa >> 48];
+			mantissa = (mantissa << 4) & ((1ULL << 52) - 1);
+		}
+	}
+
+	// zero has exponent 0, subnormals the exponent of the smallest normal
+	int e = exponent ? exponent - 1023 : (bits << 1 ? -1022 : 0);
+	out[n++] = 'p';
+	out[n++] = e < 0 ? '-' : '+';
+	if (e < 0) {
+		e = -e;
+	}
+
+	char digits[4];
+	unsigned int i = sizeof(digits);
+	do {
+		digits[--i] = '0' + e % 10;
+		e /= 10;
+	} while (e);
+	memcpy(out + n, digits + i, sizeof(digits) - i);
+	n += sizeof(digits) - i;
+
+	return str_insert_n(str, out, n);
 }
 
 int str_copy(string_t* source, string_t* destination)
@@ -101,14 +216,13 @@ int str_copy(string_t* source, string_t* destination)
 		return ERROR_INTERNAL;
 	}
 
-	if (source->length >= destination->alloc_size) {
-		destination->str = realloc(destination->str, source->length + 1);
-		if (!destination->str) {
-			return ERROR_INTERNAL;
-		}
-		destination->alloc_size = source->length + 1;
+	destination->length = 0;
+	if (str_reserve(destination, source->length)) {
+		return ERROR_INTERNAL;
 	}
-	strcpy(destination->str, source->str);
+	// source can be a view, which is not ended with '\0'
+	memcpy(destination->str, source->str, source->length);
+	destination->str[source->length] = '\0';
 	destination->length = source->length;
 	return SUCCESS;
 }
@@ -126,7 +240,7 @@ void str_clear(string_t *src)
 int str_isequal(const string_t src, const string_t dst)
 {
 	if (src.length == dst.length) {
-		return !strcmp(src.str, dst.str);
+		return !memcmp(src.str, dst.str, src.length);
 	}
 	return 0;
 }
@@ -14,12 +14,24 @@
 #ifndef _STR_H_
 #define _STR_H_
 
+#include <stdint.h>
+
 typedef struct {
-	char *str; 					// string ended with '\0'
+	char *str; 					// string ended with '\0' (views are not terminated)
 	unsigned int length; 		// real length of the string
-	unsigned int alloc_size; 	// allocated space for the string
+	unsigned int alloc_size; 	// allocated space for the string, 0 for views
 } string_t;
 
+#define STR_BORROWED 0x80000000u	// alloc_size flag, characters are in caller's buffer
+#define STR_BUFFER_SIZE 64			// size of stack buffer of short strings
+
+// declare string stored in stack buffer until it outgrows it (small string
+// optimization), string must not be used after the end of declaring block
+#define STR_BUFFERED(name)							\
+	char name##_buffer[STR_BUFFER_SIZE];			\
+	string_t name;									\
+	str_init_buffer(&name, name##_buffer, STR_BUFFER_SIZE)
+
 /**
  * @brief Inicialization of string struct.
  *
@@ -29,6 +41,38 @@ typedef struct {
  */
 int str_init(string_t* s);
 
+/**
+ * @brief Initialize string in caller's buffer, string is moved to heap once
+ *  it doesn't fit into buffer (use str_own() before passing it out of scope
+ *  of the buffer)
+ *
+ * @param s Pointer to the string
+ * @param buffer Storage for short string
+ * @param size Size of buffer
+ */
+void str_init_buffer(string_t *s, char *buffer, unsigned int size);
+
+/**
+ * @brief Move string stored in caller's buffer (or view) to heap, so it
+ *  owns its characters
+ *
+ * @param s Pointer to the string
+ *
+ * @return 0 if successful, else return 1
+ */
+int str_own(string_t *s);
+
+/**
+ * @brief Create view into existing characters (e.g. source buffer), view
+ *  is not ended with '\0', it must not be modified and freeing it does nothing
+ *
+ * @param str Pointer to the first character
+ * @param length Number of characters
+ *
+ * @return View of given characters
+ */
+string_t str_view(const char *str, unsigned int length);
+
 /**
  * @brief Free allocated string
  *
@@ -57,6 +101,17 @@ int str_add_char(string_t* s, char c);
  */
 int str_insert(string_t* str, char* insert);
 
+/**
+ * @brief Insert first len characters of insert into string_t
+ *
+ * @param str	 String structure to insert into
+ * @param insert Characters to insert (do not have to be ended with '\0')
+ * @param len	 Number of characters to insert
+ *
+ * @return 0 if successful, else return 1
+ */
+int str_insert_n(string_t* str, const char* insert, unsigned int len);
+
 /**
  * @brief Insert integer value to string_t
  *
@@ -65,7 +120,7 @@ int str_insert(string_t* str, char* insert);
  *
  * @return 0 if successful, else return 1
  */
-int str_insert_int(string_t* str, int num);
+int str_insert_int(string_t* str, int64_t num);
 
 /**
  * @brief Insert double value to string_t
@@ -87,6 +142,18 @@ int str_insert_double(string_t* str, double num);
  */
 int str_copy(string_t* source, string_t* destination);
 
+/**
+ * @brief Make space for at least length characters and '\0', capacity is
+ *  doubled, so appending n characters costs O(n) in total. String which
+ *  doesn't own its characters (buffer, view) is copied to heap
+ *
+ * @param s String
+ * @param length Number of characters
+ *
+ * @return 0 if successful, else return 1
+ */
+int str_reserve(string_t *s, unsigned int length);
+
 /**
  * @brief Clear string
  *
@@ -14,26 +14,17 @@
 /* Implementation of hash table was taken from Language C course,
  * original implementation was made by Vojtech Eichler (xeichl01) */
 
-#include <stdint.h>
 #include "symtable.h"
+#include "arena.h"
 #include "error.h"
 
-size_t hash_function(string_t str)
-{
-	uint32_t h=0;
-	const unsigned char *p;
-	for(p=(const unsigned char*)str.str; *p!='\0'; p++)
-		h = 65599*h + *p;
-	return h % GLOBAL_SYM_SIZE;
-}
-
 global_symtab_t *global_create()
 {
 	global_symtab_t *table;
 
 	// if allocation fails, return NULL, allocating space for hash table +
 	// n * pointer to hash table item/record
-	if (!(table = malloc(sizeof(*table) + GLOBAL_SYM_SIZE * sizeof(struct global_item*))))
+	if (!(table = arena_alloc(&arena, sizeof(*table) + GLOBAL_SYM_SIZE * sizeof(struct global_item*))))
 		return NULL;
 
 	// hash table initialization
@@ -44,17 +35,17 @@ global_symtab_t *global_create()
 	return table;
 }
 
-struct global_item *global_find(global_symtab_t *gs, string_t key)
+struct global_item *global_find(global_symtab_t *gs, atom_t *key)
 {
 	// finding index of key in hash table
-	size_t index = hash_function(key);
+	size_t index = SYMTAB_INDEX(key, GLOBAL_SYM_SIZE);
 
 	// cycling through all records at index in hash table
 	struct global_item *item;
 	item = gs->func[index];
 	while (item) {
-		// if current item has the wanted key
-		if (str_isequal(key, item->key))
+		// if current item has the wanted key (atoms are unique)
+		if (item->key == key)
 			return item;
 		item = item->next;
 	}
@@ -63,25 +54,23 @@ struct global_item *global_find(global_symtab_t *gs, string_t key)
 	return NULL;
 }
 
-struct global_item *global_create_fun(string_t key)
+struct global_item *global_create_fun(atom_t *key)
 {
-    struct global_item *new_func = malloc(sizeof(*new_func));
+    struct global_item *new_func = arena_alloc(&arena, sizeof(*new_func));
+	if (new_func == NULL) return NULL;
 
 	// initialize all values
 	new_func->defined = false;
-	if (str_init(&new_func->key)) return NULL;
+	new_func->key = key;
 	if (str_init(&new_func->retvals)) return NULL;
 	if (str_init(&new_func->params)) return NULL;
 	new_func->next = NULL;
 
-	// copy key to function key
-	if (str_copy(&key, &new_func->key)) return NULL;
-
 	return new_func;
 }
 
 
-struct global_item *global_add(global_symtab_t *gs, string_t key)
+struct global_item *global_add(global_symtab_t *gs, atom_t *key)
 {
 	// try to find if function already exists and return pointer to it
 	struct global_item *find = global_find(gs, key);
@@ -90,7 +79,7 @@ struct global_item *global_add(global_symtab_t *gs, string_t key)
 	}
 
 	// create new function and insert it at the beginning of list
-	size_t hash = hash_function(key);
+	size_t hash = SYMTAB_INDEX(key, GLOBAL_SYM_SIZE);
 	struct global_item *new_func = global_create_fun(key);
 	if (new_func == NULL) {
 		return NULL;
@@ -120,39 +109,33 @@ bool global_check_declared(global_symtab_t *gs)
 
 void global_destroy(global_symtab_t *gs)
 {
-	struct global_item *tmp, *del;
+	struct global_item *tmp;
 
-	// free all link-listed functions
+	// functions are in arena, only their strings are on heap
 	for (unsigned int i = 0; i < gs->size; i++) {
-		tmp = gs->func[i];
-		while (tmp != NULL) {
-			del = tmp;
-			tmp = tmp->next;
-			// free all allocated strings
-			str_free(&del->key);
-			str_free(&del->params);
-			str_free(&del->retvals);
-			free(del);
+		for (tmp = gs->func[i]; tmp != NULL; tmp = tmp->next) {
+			str_free(&tmp->params);
+			str_free(&tmp->retvals);
 		}
 	}
-
-	free(gs);
 }
 
-local_symtab_t *local_create(string_t key)
+local_symtab_t *local_create(atom_t *key)
 {
-	// allocate memory for table
-	local_symtab_t *local = malloc(sizeof(*local) + LOCAL_SYM_SIZE * sizeof(struct local_data*));
+	// allocate memory for table (table of left block is reused)
+	local_symtab_t *local = arena_alloc(&arena, sizeof(*local) + LOCAL_SYM_SIZE * sizeof(struct local_data*));
 	if (local == NULL) {
 		return NULL;
 	}
 
 	// initialize values
-	if (str_init(&local->key)) return NULL;
-	if (str_copy(&key, &local->key)) return NULL;
+	local->key = key;
 	local->if_cnt = 0;
 	local->after_else = 0;
 	local->while_cnt = 0;
+	local->cond_start = 0;
+	local->cond_end = 0;
+	local->slots = 0;
 	local->depth = 0;
 	local->alloc_size = LOCAL_SYM_SIZE;
 	local->next = NULL;
@@ -177,6 +160,8 @@ int local_new_depth(local_symtab_t **previous)
 	}
 
 	new_local->depth = (*previous)->depth+1;
+	// variables of enclosing blocks keep their frame variables
+	new_local->slots = (*previous)->slots;
 
 	new_local->next = *previous;
 	*previous = new_local;
@@ -184,15 +169,18 @@ int local_new_depth(local_symtab_t **previous)
 	return 0;
 }
 
-struct local_data *local_add(local_symtab_t *local_tab, string_t name, bool init)
+struct local_data *local_add(local_symtab_t *local_tab, atom_t *name, bool init)
 {
 
-    struct local_data *id = malloc(sizeof(struct local_data));
-    if (str_init(&(id->name))) return NULL;
-    if (str_copy(&name, &(id->name))) return NULL;
+    struct local_data *id = arena_alloc(&arena, sizeof(struct local_data));
+    if (id == NULL) return NULL;
+    id->name = name;
     id->init = init;
     id->type = NIL_T;
-    size_t index = hash_function(name);
+    id->mangled = NULL;
+    id->depth = local_tab->depth;
+    id->known = KNOWN_NOTHING;
+    size_t index = SYMTAB_INDEX(name, LOCAL_SYM_SIZE);
     id->next = local_tab->data[index];
     local_tab->data[index] = id;
 
@@ -212,14 +200,14 @@ void local_add_type(struct local_data *data, keyword_t kw)
 	}
 }
 
-struct local_data *local_find(local_symtab_t *local_tab, string_t name)
+struct local_data *local_find(local_symtab_t *local_tab, atom_t *name)
 {
 	local_symtab_t *tmp = local_tab;
 	if (tmp == NULL) {
 		return NULL;
 	}
 
-    size_t index = hash_function(name);
+    size_t index = SYMTAB_INDEX(name, LOCAL_SYM_SIZE);
     // variable that allows us to cycle through items
     // with same hash in hash table
     struct local_data *current = NULL;
@@ -229,7 +217,7 @@ struct local_data *local_find(local_symtab_t *local_tab, string_t name)
         current = tmp->data[index];
 
         while(current) {
-            if (str_isequal(current->name, name))
+            if (current->name == name)
                 return current;
             current = current->next;
         }
@@ -240,21 +228,37 @@ struct local_data *local_find(local_symtab_t *local_tab, string_t name)
 		}
 
 		// check if next local symtab has different key
-		if (!str_isequal(tmp->key, tmp->next->key)) {
+		if (tmp->key != tmp->next->key) {
 			return NULL;
 		}
 		tmp = tmp->next;
 	}
 }
 
-local_symtab_t *local_symtab_find(local_symtab_t *local_tab, string_t name)
+struct local_data *local_find_top(local_symtab_t *local_tab, atom_t *name)
+{
+	if (local_tab == NULL) {
+		return NULL;
+	}
+
+    struct local_data *current = local_tab->data[SYMTAB_INDEX(name, LOCAL_SYM_SIZE)];
+    while (current) {
+        if (current->name == name)
+            return current;
+        current = current->next;
+    }
+
+	return NULL;
+}
+
+local_symtab_t *local_symtab_find(local_symtab_t *local_tab, atom_t *name)
 {
 	local_symtab_t *tmp = local_tab;
 	if (tmp == NULL) {
 		return NULL;
 	}
 
-    size_t index = hash_function(name);
+    size_t index = SYMTAB_INDEX(name, LOCAL_SYM_SIZE);
     struct local_data *current = NULL;
 
 	// iterate through all local symtabs
@@ -262,7 +266,7 @@ local_symtab_t *local_symtab_find(local_symtab_t *local_tab, string_t name)
         current = tmp->data[index];
 
         while(current) {
-            if (str_isequal(current->name, name))
+            if (current->name == name)
                     return tmp;
             current = current->next;
         }
@@ -273,7 +277,7 @@ local_symtab_t *local_symtab_find(local_symtab_t *local_tab, string_t name)
 		}
 
 		// check if next local symtab has different key
-		if (!str_isequal(tmp->key, tmp->next->key)) {
+		if (tmp->key != tmp->next->key) {
 			return NULL;
 		}
 		tmp = tmp->next;
@@ -312,19 +316,15 @@ void local_delete_top(local_symtab_t **local_tab)
 	del = *local_tab;
 	*local_tab = (*local_tab)->next;
 
-	// free key of local symtable
-	str_free(&del->key);
 	for (unsigned int i = 0; i < LOCAL_SYM_SIZE; i++) {
         while(del->data[i]) {
             struct local_data *tmp = del->data[i]->next;
-            // free names of all identifiers
-            str_free(&(del->data[i]->name));
-            free(del->data[i]);
+            arena_free(&arena, del->data[i], sizeof(struct local_data));
             del->data[i] = tmp;
         }
 	}
-	// free the local table itself
-	free(del);
+	// return the local table itself to arena for next block
+	arena_free(&arena, del, sizeof(*del) + LOCAL_SYM_SIZE * sizeof(struct local_data*));
 }
 
 void local_destroy(local_symtab_t *local_tab)
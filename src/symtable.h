@@ -23,9 +23,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "scanner.h"	// keyword_t for variable
+#include "atom.h"
 #include "str.h"
 
+// index to hashtable from precomputed hash of atom
+#define SYMTAB_INDEX(atom, size) ((atom)->hash % (size))
+
 // Identificator types
 typedef enum type_t {
 	STR_T,
@@ -34,13 +39,29 @@ typedef enum type_t {
 	NIL_T
 } type_t;
 
+/**
+ * @brief What is known about value of variable in generated code, integer
+ *  value is in range min..max (whole range of int64 if nothing is known)
+ */
+typedef struct known {
+	bool not_nil;				// Value surely isn't nil
+	int64_t min;
+	int64_t max;
+} known_t;
+
+// nothing is known about value, it can be nil
+#define KNOWN_NOTHING ((known_t){false, INT64_MIN, INT64_MAX})
+
 /**
  * @brief Information about identificators
  */
 struct local_data {
-	string_t name;
+	atom_t *name;
 	type_t type;
 	bool init;
+	atom_t *mangled;			// Unique name in generated code (created by generator)
+	unsigned int depth;			// Depth of block in which variable was declared
+	known_t known;				// Value at current point of generated code
     struct local_data *next;
 };
 
@@ -48,12 +69,15 @@ struct local_data {
  * @brief Information about local symtable for single function
  */
 typedef struct local_symtab {
-	string_t key;
+	atom_t *key;					// Name of function
 	unsigned int depth;				// Level of depth (if, while ...)
 	unsigned int alloc_size;		// Size of allocated space for variables
 	unsigned int if_cnt;			// Counter of if statements for unique label generation
 	unsigned int after_else;		// Number to create unique labels for nested ifs
 	unsigned int while_cnt;			// Counter of while statements for unique label generation
+	size_t cond_start;				// Condition of while (with its jump) in instruction buffer,
+	size_t cond_end;				// it's repeated at the end of loop (cond_end 0 if it's not)
+	unsigned int slots;				// Frame variables taken by locals of this and enclosing blocks
 	struct local_symtab *next;		// Pointer to next local TS (creating linked list)
 	struct local_data *data[];		// Variables inside function
 } local_symtab_t;
@@ -63,7 +87,7 @@ typedef struct local_symtab {
  */
 struct global_item {
 	bool defined;
-	string_t key;				// Name of function
+	atom_t *key;				// Name of function
 	string_t retvals;			// Function return values in string format
 	string_t params;			// Parameters of function in string format
 	struct global_item *next;
@@ -77,13 +101,6 @@ typedef struct global_symtab {
 	struct global_item *func[];
 } global_symtab_t;
 
-/**
- * @brief Create index to hashtable from string
- * @param key Key in string format
- * @return Index to hashtable based on key
- */
-size_t hash_function(string_t key);
-
 /**
  * @brief Create global symtable with initialized values
  * @return Initialized global symtable
@@ -96,7 +113,7 @@ global_symtab_t *global_create();
  * @param key Function name
  * @return Pointer to found function or NULL
  */
-struct global_item *global_find(global_symtab_t *gs, string_t key);
+struct global_item *global_find(global_symtab_t *gs, atom_t *key);
 
 /**
  * @brief Insert new function to gs, if no function with same key is found
@@ -104,7 +121,7 @@ struct global_item *global_find(global_symtab_t *gs, string_t key);
  * @param key Function name
  * @return Pointer to found/created function
  */
-struct global_item *global_add(global_symtab_t *gs, string_t key);
+struct global_item *global_add(global_symtab_t *gs, atom_t *key);
 
 /**
  * @brief Check if all functions in global symtable were defined
@@ -114,7 +131,8 @@ struct global_item *global_add(global_symtab_t *gs, string_t key);
 bool global_check_declared(global_symtab_t *gs);
 
 /**
- * @brief Destroy global symtable and free all its resources
+ * @brief Free strings of all functions, symtable itself is allocated in
+ *  arena and it's released with it
  * @param gs Pointer to global symtable
  */
 void global_destroy(global_symtab_t *gs);
@@ -128,7 +146,7 @@ void global_destroy(global_symtab_t *gs);
  * @param key Name of function
  * @return Pointer to newly created local symtable
  */
-local_symtab_t *local_create(string_t key);
+local_symtab_t *local_create(atom_t *key);
 
 /**
  * @brief Create new depth of last function in local symtable
@@ -140,10 +158,11 @@ int local_new_depth(local_symtab_t **previous);
 
 /**
  * @brief Add new variable into local symtable (used before local_add_type)
+ * @param local_tab Pointer to local symtable
  * @param name Name of new variable
  * @return Pointer to new variable
  */
-struct local_data *local_add(local_symtab_t *local_tab, string_t name, bool init);
+struct local_data *local_add(local_symtab_t *local_tab, atom_t *name, bool init);
 
 /**
  * @brief Add type of identifier (after local_add)
@@ -158,7 +177,15 @@ void local_add_type(struct local_data *data, keyword_t kw);
  * @param name Name of identifier
  * @return Pointer to item, if item was not found NULL
  */
-struct local_data *local_find(local_symtab_t *local_tab, string_t name);
+struct local_data *local_find(local_symtab_t *local_tab, atom_t *name);
+
+/**
+ * @brief Find identifier only in the top (current depth) of local symtable
+ * @param local_tab Pointer to local symtable
+ * @param name Name of identifier
+ * @return Pointer to item, if item was not found NULL
+ */
+struct local_data *local_find_top(local_symtab_t *local_tab, atom_t *name);
 
 /**
  * @brief Find identifier in local symtable linked list and return local symtable frame
@@ -166,7 +193,7 @@ struct local_data *local_find(local_symtab_t *local_tab, string_t name);
  * @param name Name of identifier
  * @return Pointer to local symtable frame, in which id was found, otherwise return NULL
  */
-local_symtab_t *local_symtab_find(local_symtab_t *local_tab, string_t name);
+local_symtab_t *local_symtab_find(local_symtab_t *local_tab, atom_t *name);
 
 /**
  * @brief Increase if_cnt in current local symtable
@@ -187,13 +214,13 @@ void local_after_else(local_symtab_t *local_tab);
 void local_add_while(local_symtab_t *local_tab);
 
 /**
- * @brief Free top of the local symtable and all its resources
+ * @brief Return top of the local symtable and its variables to arena
  * @param local_tab Pointer to active local symtable
  */
 void local_delete_top(local_symtab_t **local_tab);
 
 /**
- * @brief Free local symtable and all its resources
+ * @brief Return all blocks of local symtable to arena
  * @param local_tab Pointer to active local symtable
  */
 void local_destroy(local_symtab_t *local_tab);
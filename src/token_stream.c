@@ -0,0 +1,165 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file token_stream.c
+ *
+ * @brief Implementation of token stream
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#include <stdlib.h>
+#include "token_stream.h"
+#include "error.h"
+
+/**
+ * @brief Make space for at least one more token and attribute
+ */
+static int token_stream_grow(token_stream_t *ts)
+{
+    if (ts->count == ts->capacity) {
+        size_t capacity = ts->capacity ? ts->capacity * 2 : TOKEN_STREAM_SIZE;
+
+        unsigned char *type = realloc(ts->type, capacity * sizeof(*type));
+        if (type == NULL) {
+            return ERROR_INTERNAL;
+        }
+        ts->type = type;
+
+        uint32_t *attr = realloc(ts->attr, capacity * sizeof(*attr));
+        if (attr == NULL) {
+            return ERROR_INTERNAL;
+        }
+        ts->attr = attr;
+
+        size_t *offset = realloc(ts->offset, capacity * sizeof(*offset));
+        if (offset == NULL) {
+            return ERROR_INTERNAL;
+        }
+        ts->offset = offset;
+        ts->capacity = capacity;
+    }
+
+    if (ts->value_count == ts->value_capacity) {
+        size_t capacity = ts->value_capacity ? ts->value_capacity * 2 : TOKEN_STREAM_SIZE;
+
+        token_attribute_t *value = realloc(ts->value, capacity * sizeof(*value));
+        if (value == NULL) {
+            return ERROR_INTERNAL;
+        }
+        ts->value = value;
+        ts->value_capacity = capacity;
+    }
+
+    return SUCCESS;
+}
+
+int token_stream_fill(token_stream_t *ts)
+{
+    token_t token;
+
+    do {
+        if (token_stream_grow(ts)) {
+            return ERROR_INTERNAL;
+        }
+
+        ts->error = get_token(&token);
+        if (ts->error) {
+            ts->error_offset = token.offset;
+            break;
+        }
+
+        ts->type[ts->count] = token.type;
+        ts->offset[ts->count] = token.offset;
+        switch (token.type) {
+            case TOK_KEYWORD:
+                ts->attr[ts->count] = token.attribute.keyword;
+                break;
+            case TOK_ID:
+            case TOK_STRING:
+            case TOK_INT:
+            case TOK_DECIMAL:
+                ts->attr[ts->count] = ts->value_count;
+                ts->value[ts->value_count++] = token.attribute;
+                break;
+            default:
+                ts->attr[ts->count] = 0;
+                break;
+        }
+        ts->count++;
+    } while (token.type != TOK_EOF);
+
+    // first call of token_stream_next() moves to the first token
+    ts->pos = (size_t)-1;
+
+    return SUCCESS;
+}
+
+int token_stream_next(token_stream_t *ts)
+{
+    if (ts->pos + 1 < ts->count) {
+        ts->pos++;
+        return SUCCESS;
+    }
+
+    // stream either ended with TOK_EOF (stays there) or with an error
+    if (ts->error) {
+        ts->pos = ts->count;
+    }
+    return ts->error;
+}
+
+void token_stream_unget(token_stream_t *ts)
+{
+    ts->pos--;
+}
+
+token_type_t token_stream_peek(token_stream_t *ts, size_t n)
+{
+    if (ts->pos + n >= ts->count) {
+        return TOK_NOTHING;
+    }
+
+    return (token_type_t)ts->type[ts->pos + n];
+}
+
+size_t token_stream_offset(token_stream_t *ts)
+{
+    return ts->pos < ts->count ? ts->offset[ts->pos] : ts->error_offset;
+}
+
+void token_stream_get(token_stream_t *ts, token_t *token)
+{
+    token->type = TOKEN_TYPE(ts);
+    token->offset = ts->offset[ts->pos];
+
+    if (token->type == TOK_KEYWORD) {
+        token->attribute.keyword = TOKEN_KEYWORD(ts);
+    } else if (token->type == TOK_ID || token->type == TOK_STRING ||
+            token->type == TOK_INT || token->type == TOK_DECIMAL) {
+        token->attribute = TOKEN_VALUE(ts);
+    }
+}
+
+void token_stream_free(token_stream_t *ts)
+{
+    for (size_t i = 0; i < ts->count; i++) {
+        if (ts->type[i] == TOK_STRING) {
+            str_free(&ts->value[ts->attr[i]].s);
+        }
+    }
+
+    free(ts->type);
+    free(ts->attr);
+    free(ts->value);
+    free(ts->offset);
+    ts->type = NULL;
+    ts->attr = NULL;
+    ts->value = NULL;
+    ts->offset = NULL;
+    ts->count = ts->capacity = 0;
+    ts->value_count = ts->value_capacity = 0;
+}
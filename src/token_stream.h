@@ -0,0 +1,99 @@
+/**
+ * VUT IFJ Project 2021.
+ *
+ * @file token_stream.h
+ *
+ * @brief Whole input tokenized into contiguous arrays (struct of arrays)
+ *
+ * @author Vojtěch Eichler
+ * @author Václav Korvas
+ * @author Tomáš Matuš
+ * @author Adam Zvara
+ */
+
+#ifndef _TOKEN_STREAM_H_
+#define _TOKEN_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scanner.h"
+
+#define TOKEN_STREAM_SIZE 1024      // initial number of tokens
+
+/**
+ * @struct token_stream
+ *
+ * @brief Tokens of whole input, i-th token is described by type[i] and
+ *  attr[i], attr is keyword for TOK_KEYWORD or index into value for
+ *  identifiers, strings and numbers (operators have no attribute)
+ */
+typedef struct token_stream {
+    unsigned char *type;        // type of every token
+    uint32_t *attr;             // keyword or index into value
+    token_attribute_t *value;   // attributes of ids, strings and numbers
+    size_t *offset;             // offset of every token in source
+    size_t count;               // number of tokens
+    size_t capacity;            // allocated tokens
+    size_t value_count;         // number of attributes
+    size_t value_capacity;      // allocated attributes
+    size_t pos;                 // index of current token
+    int error;                  // return code of scanner after last token
+    size_t error_offset;        // offset of token which scanner rejected
+} token_stream_t;
+
+// type of current token
+#define TOKEN_TYPE(ts) ((token_type_t)(ts)->type[(ts)->pos])
+
+// keyword of current token (TOK_KEYWORD)
+#define TOKEN_KEYWORD(ts) ((keyword_t)(ts)->attr[(ts)->pos])
+
+// attribute of current token (TOK_ID, TOK_STRING, TOK_INT, TOK_DECIMAL)
+#define TOKEN_VALUE(ts) ((ts)->value[(ts)->attr[(ts)->pos]])
+
+/**
+ * @brief Tokenize whole input, scanning stops at first lexical error,
+ *  which is returned when parser reaches it by token_stream_next()
+ *
+ * @param ts Token stream to be filled
+ *
+ * @return SUCCESS (0) if successful, ERROR_INTERNAL if allocation failed
+ */
+int token_stream_fill(token_stream_t *ts);
+
+/**
+ * @brief Move to the next token, stream stays at TOK_EOF once it's reached
+ *
+ * @return SUCCESS (0) or return code of scanner for this token
+ */
+int token_stream_next(token_stream_t *ts);
+
+/**
+ * @brief Move back to previous token, next call of token_stream_next()
+ *  reads current token again
+ */
+void token_stream_unget(token_stream_t *ts);
+
+/**
+ * @brief Get type of token n positions after current one (lookahead)
+ *
+ * @return Type of token or TOK_NOTHING if stream ends before it
+ */
+token_type_t token_stream_peek(token_stream_t *ts, size_t n);
+
+/**
+ * @brief Get offset of current token in source, offset of rejected token
+ *  if token_stream_next() failed on lexical error
+ */
+size_t token_stream_offset(token_stream_t *ts);
+
+/**
+ * @brief Copy current token into token structure
+ */
+void token_stream_get(token_stream_t *ts, token_t *token);
+
+/**
+ * @brief Free all tokens (strings owned by tokens included)
+ */
+void token_stream_free(token_stream_t *ts);
+
+#endif // _TOKEN_STREAM_H_
@@ -4,6 +4,8 @@ RED='\033[0;31m'
 BLUE='\033[0;34m'
 NC='\033[0m'
 ORANGE='\033[0;33m'
+# every test is compiled at each optimization level
+OPT_LEVELS=${OPT_LEVELS:-"-O0 -O1 -O2"}
 PARSER_DIR="builtin"
 for f in $PARSER_DIR; do
     PARSER_TEST_DIR=parser-tests/$f
@@ -19,13 +21,16 @@ for f in $PARSER_DIR; do
         DIFF=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).diff
 		TEXT=$PARSER_TEST_DIR/$(echo $f | cut -d '.' -f1).txt
         echo -e "${BLUE}Testing:${NC} $TEST_NAME"
-		# Run tests
-		../src/parser < $PARSER_TEST_DIR/$f > $OUTPUT
-		./../interpret/ic21int $OUTPUT < $TEXT > $RESULT 2>/dev/null
-		diff $RESULT $EXPECTED > $DIFF
-		if [ "$?" -ne 0 ]; then
-			echo -e "${RED}FAIL${NC} - CHECK .diff FILE" 
-		fi
+		for level in $OPT_LEVELS; do
+			# Run tests
+			../src/parser $level < $PARSER_TEST_DIR/$f > $OUTPUT
+			./../interpret/ic21int $OUTPUT < $TEXT > $RESULT 2>/dev/null
+			diff $RESULT $EXPECTED > $DIFF
+			if [ "$?" -ne 0 ]; then
+				echo -e "${RED}FAIL${NC} ($level) - CHECK .diff FILE" 
+				break
+			fi
+		done
 
     done
 done
@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# Run correct programs from parser tests in ic21int and print number of
+# executed instructions for every optimization level given as argument
+# (default -O0 -O1 -O2), EXEC_TESTS selects programs
+
+EXEC_TESTS=${EXEC_TESTS:-"parser-tests/simple/*.input"}
+LEVELS=${@:-"-O0 -O1 -O2"}
+CODE=$(mktemp)
+
+for level in $LEVELS; do
+    TOTAL=0
+    for file in $EXEC_TESTS; do
+        ../src/parser $level < $file > $CODE 2>/dev/null || continue
+        n=$(../interpret/ic21int -v $CODE 2>&1 </dev/null | grep -o "Executing instruction" | wc -l)
+        TOTAL=$((TOTAL + n))
+    done
+    echo "$level: $TOTAL executed instructions"
+done
+
+rm -f $CODE
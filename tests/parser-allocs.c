@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Count allocations made by whole compiler, build with `make parser-allocs`
+ * and run with ./parser_allocs.sh, which prints malloc calls per compiled KLOC
+ *
+ * Parser is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc and
+ * number of allocations is printed to stderr when the parser exits */
+
+static unsigned long allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    allocations++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+static void report() __attribute__((destructor));
+
+static void report()
+{
+    fprintf(stderr, "allocations: %lu\n", allocations);
+}
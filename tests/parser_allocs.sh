@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Compile correct programs from parser tests with parser-allocs and print
+# number of malloc, calloc and realloc calls per thousand compiled lines
+
+ALLOCS=0
+LINES=0
+
+for file in parser-tests/simple/*.input; do
+    n=$(./parser-allocs < $file 2>&1 >/dev/null | sed -n 's/^allocations: //p')
+    ALLOCS=$((ALLOCS + n))
+    LINES=$((LINES + $(wc -l < $file)))
+done
+
+echo "lines: $LINES, allocations: $ALLOCS"
+echo "allocations per KLOC: $((ALLOCS * 1000 / LINES))"
@@ -4,6 +4,8 @@ RED='\033[0;31m'
 BLUE='\033[0;34m'
 NC='\033[0m'
 ORANGE='\033[0;33m'
+# every test is compiled at each optimization level
+OPT_LEVELS=${OPT_LEVELS:-"-O0 -O1 -O2"}
 PARSER_DIR="error failed_tests simple need_to_fix"
 for f in $PARSER_DIR; do
     PARSER_TEST_DIR=parser-tests/$f
@@ -19,21 +21,24 @@ for f in $PARSER_DIR; do
         DIFF=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).diff
 
         echo -e "${BLUE}Testing:${NC} $TEST_NAME"
-        if [ $PARSER_TEST_DIR == "parser-tests/error" ]; then
-            # Run tests
-            ../src/parser < $PARSER_TEST_DIR/$f >>/dev/null 2>&1
-            if [ "$?" != $RETURN ]; then
-                echo -e "${RED}FAIL${NC}"
+        for level in $OPT_LEVELS; do
+            if [ $PARSER_TEST_DIR == "parser-tests/error" ]; then
+                # Run tests
+                ../src/parser $level < $PARSER_TEST_DIR/$f >>/dev/null 2>&1
+                if [ "$?" != $RETURN ]; then
+                    echo -e "${RED}FAIL${NC} ($level)"
+                fi
+            else
+                # Run tests
+                ../src/parser $level < $PARSER_TEST_DIR/$f > $OUTPUT
+                ./../interpret/ic21int $OUTPUT > $RESULT 2>/dev/null
+                diff $RESULT $EXPECTED > $DIFF
+                if [ $? -ne 0 ]; then
+                    echo -e "${RED}FAIL${NC} ($level) - CHECK .diff FILE"
+                    break
+                fi
             fi
-        else
-            # Run tests
-            ../src/parser < $PARSER_TEST_DIR/$f > $OUTPUT
-            ./../interpret/ic21int $OUTPUT > $RESULT 2>/dev/null
-            diff $RESULT $EXPECTED > $DIFF
-            if [ $? -ne 0 ]; then
-                echo -e "${RED}FAIL${NC} - CHECK .diff FILE"
-            fi
-        fi
+        done
 
 
     done
@@ -41,3 +46,4 @@ done
 
 bash runtime.sh
 bash built_in.sh
+bash peephole.sh
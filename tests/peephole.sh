@@ -0,0 +1,34 @@
+#!/bin/bash
+
+RED='\033[0;31m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+ORANGE='\033[0;33m'
+PARSER_DIR="peephole"
+for f in $PARSER_DIR; do
+    PARSER_TEST_DIR=parser-tests/$f
+    PARSER_INPUT_FILES=$(ls $PARSER_TEST_DIR | grep .input)
+	echo -e "${ORANGE}${f^^}:${NC}"
+    for f in $PARSER_INPUT_FILES; do
+        TEST_NAME=$(echo $f | cut -d'.' -f1)
+        OUTPUT=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).output
+        RESULT=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).result
+        EXPECTED=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).expected
+        RULES=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).rules
+        DIFF=$PARSER_TEST_DIR/$(echo $f | cut -d'.' -f1).diff
+
+        echo -e "${BLUE}Testing:${NC} $TEST_NAME"
+        # Run tests, .rules holds how many times each rule fired at -O1
+        ../src/parser -O1 -s < $PARSER_TEST_DIR/$f 2> $RESULT > $OUTPUT
+        grep "^peephole:" $RESULT | diff - $RULES > $DIFF
+        if [ $? -ne 0 ]; then
+            echo -e "${RED}FAIL${NC} (rules) - CHECK .diff FILE"
+            continue
+        fi
+        ./../interpret/ic21int $OUTPUT > $RESULT 2>/dev/null
+        diff $RESULT $EXPECTED > $DIFF
+        if [ $? -ne 0 ]; then
+            echo -e "${RED}FAIL${NC} - CHECK .diff FILE"
+        fi
+    done
+done
@@ -4,6 +4,8 @@ RED='\033[0;31m'
 BLUE='\033[0;34m'
 NC='\033[0m'
 ORANGE='\033[0;33m'
+# every test is compiled at each optimization level
+OPT_LEVELS=${OPT_LEVELS:-"-O0 -O1 -O2"}
 PARSER_DIR="runtime"
 for f in $PARSER_DIR; do
     PARSER_TEST_DIR=parser-tests/$f
@@ -20,12 +22,14 @@ for f in $PARSER_DIR; do
 
         echo -e "${BLUE}Testing:${NC} $TEST_NAME"
         if [ $PARSER_TEST_DIR == "parser-tests/runtime" ]; then
-            # Run tests
-            ../src/parser < $PARSER_TEST_DIR/$f > $OUTPUT
-            ./../interpret/ic21int $OUTPUT
-            if [ "$?" != $RETURN ]; then
-                echo -e "${RED}FAIL${NC}"
-            fi
+            for level in $OPT_LEVELS; do
+                # Run tests
+                ../src/parser $level < $PARSER_TEST_DIR/$f > $OUTPUT
+                ./../interpret/ic21int $OUTPUT
+                if [ "$?" != $RETURN ]; then
+                    echo -e "${RED}FAIL${NC} ($level)"
+                fi
+            done
         fi
 
     done
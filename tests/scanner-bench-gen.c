@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Generate synthetic Teal input for scanner benchmark, build with
+ * `make bench-scanner`, usage: ./scanner-bench-gen kind size > file.tl
+ *   kind - identifiers, numbers, strings or comments
+ *   size - approximate size of output in bytes, suffix K, M or G allowed */
+
+static unsigned long long seed = 1;
+
+// deterministic pseudo random numbers, every run generates the same input
+static unsigned long next_random()
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned long)(seed >> 33);
+}
+
+// identifier heavy, every line has few keywords and lots of identifiers
+static int gen_identifiers(unsigned long i)
+{
+    return printf("local value_%lu : integer = first_%lu + second * third_%lu - do_not\n",
+            i, i % 97, i % 13);
+}
+
+// numeric table, integer and decimal literals with and without exponent
+static int gen_numbers(unsigned long i)
+{
+    return printf("t_%lu = %lu%lu, %lu.%06lu, %lu.%lue%lu, %lue-%lu\n",
+            i % 7, next_random() % 100000, next_random() % 1000000,
+            i, next_random() % 1000000, next_random() % 10, next_random(),
+            next_random() % 300, i % 1000, i % 30);
+}
+
+// string table, mostly plain strings, some of them with escape sequences
+static int gen_strings(unsigned long i)
+{
+    if (i % 4 == 0) {
+        return printf("s_%lu = \"line %lu\\n\\tindented \\\"quoted\\\" \\065\\066\\067\" .. \"%lu\"\n",
+                i % 11, i, next_random());
+    }
+    return printf("s_%lu = \"the quick brown fox jumps over the lazy dog %lu times\" .. \"%lu\"\n",
+            i % 11, i, next_random());
+}
+
+// comment banners and block comments around occasional statements
+static int gen_comments(unsigned long i)
+{
+    switch (i % 4) {
+        case 0:
+            return printf("-- ========================================================================\n");
+        case 1:
+            return printf("-- %lu: generated comment describing the statement below it in detail\n", i);
+        case 2:
+            return printf("--[[ block comment %lu spanning\n     several lines ] with brackets [\n"
+                    "     and nothing else of interest ]]\n", i);
+        default:
+            return printf("x_%lu = %lu\n", i % 5, i);
+    }
+}
+
+static unsigned long long parse_size(const char *arg)
+{
+    char *end;
+    unsigned long long size = strtoull(arg, &end, 10);
+
+    switch (*end) {
+        case 'G': case 'g': size <<= 10; // fall through
+        case 'M': case 'm': size <<= 10; // fall through
+        case 'K': case 'k': size <<= 10; break;
+        default: break;
+    }
+    return size;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        const char *name;
+        int (*line)(unsigned long);
+    } kinds[] = {
+        {"identifiers", gen_identifiers},
+        {"numbers", gen_numbers},
+        {"strings", gen_strings},
+        {"comments", gen_comments},
+    };
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s identifiers|numbers|strings|comments size\n", argv[0]);
+        return 1;
+    }
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        if (!strcmp(argv[1], kinds[k].name)) {
+            unsigned long long size = parse_size(argv[2]);
+            unsigned long long written = 0;
+
+            for (unsigned long i = 0; written < size; i++) {
+                int n = kinds[k].line(i);
+                if (n < 0) {
+                    return 1;
+                }
+                written += n;
+            }
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "unknown kind of input: %s\n", argv[1]);
+    return 1;
+}
@@ -0,0 +1,76 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/scanner.h"
+#include "../src/source.h"
+#include "../src/error.h"
+
+/* Measure throughput of get_token() on stdin, build with `make bench-scanner`
+ * and run with ./scanner_bench.sh, which compares mapped file, pipe and
+ * legacy stdio input on generated inputs
+ *
+ * Binary is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc, so
+ * every allocation of scanner goes through counting wrappers below */
+
+static unsigned long allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    allocations++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+int main ()
+{
+    token_t token;
+    struct timespec start, end;
+    unsigned long tokens = 0;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while ((ret = get_token(&token)) == SUCCESS && token.type != TOK_EOF) {
+        if (token.type == TOK_STRING) {
+            str_free(&token.attribute.s);
+        }
+        tokens++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+#ifdef SOURCE_STDIO
+    double bytes = ftell(stdin);
+#else
+    double bytes = source_tell();
+#endif
+
+    printf("tokens: %lu, bytes: %.0f, time: %.3f s, %.1f MB/s, %.2f Mtok/s, %.4f allocs/tok\n",
+            tokens, bytes, seconds, bytes / seconds / 1e6, tokens / seconds / 1e6,
+            tokens ? (double)allocations / tokens : 0.0);
+
+    if (ret != SUCCESS) {
+        fprintf(stderr, "scanner returned %d\n", ret);
+    }
+
+    source_close();
+    return ret;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include "../src/scanner.h"
 #include "../src/error.h"
 
@@ -23,7 +24,7 @@ int main ()
                 break;
             case TOK_INT:
                 printf("TOK_INT : ");
-                printf("%d\n", token->attribute.number);
+                printf("%" PRId64 "\n", token->attribute.number);
                 break;
             case TOK_DECIMAL:
                 printf("TOK_DECIMAL : ");
@@ -31,11 +32,11 @@ int main ()
                 break;
             case TOK_STRING:
                 printf("TOK_STRING : ");
-                printf("%s\n", token->attribute.s.str);
+                printf("%.*s\n", (int)token->attribute.s.length, token->attribute.s.str);
                 break;
             case TOK_ID:
                 printf("TOK_ID : ");
-                printf("%s\n", token->attribute.s.str);
+                printf("%s\n", token->attribute.id->name.str);
                 break;
             case TOK_KEYWORD:
                 printf("TOK_KEYWORD : ");
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Compare scanner throughput on large generated inputs:
+#   mmap   - regular file redirected to stdin (mapped into memory)
+#   pipe   - same input through a pipe (chunked read)
+#   stdio  - legacy getc/ungetc input (scanner-bench-stdio)
+#
+# Every run reports tokens/s, bytes/s and allocations per token.
+# BENCH_SIZE is size of each synthetic input (K, M or G suffix, 1M - 1G),
+# BENCH_KINDS selects synthetic inputs, programs are parser tests.
+
+BENCH_DIR=${BENCH_DIR:-/tmp}
+BENCH_COPIES=${BENCH_COPIES:-2000}
+BENCH_SIZE=${BENCH_SIZE:-64M}
+BENCH_KINDS=${BENCH_KINDS:-"programs identifiers numbers strings comments"}
+
+mkdir -p $BENCH_DIR
+
+bench() {
+    echo "input: $1 ($(du -h $1 | cut -f1))"
+    echo -n "  mmap:  "; ./scanner-bench < $1
+    echo -n "  pipe:  "; cat $1 | ./scanner-bench
+    echo -n "  stdio: "; ./scanner-bench-stdio < $1
+}
+
+for kind in $BENCH_KINDS; do
+    if [ $kind == "programs" ]; then
+        # Concatenate correct programs from parser tests to get large input
+        INPUT=$BENCH_DIR/ifj21_bench_programs.tl
+        if [ ! -f $INPUT ]; then
+            for i in $(seq $BENCH_COPIES); do
+                cat parser-tests/simple/*.input
+            done > $INPUT
+        fi
+    else
+        INPUT=$BENCH_DIR/ifj21_bench_${kind}_$BENCH_SIZE.tl
+        if [ ! -f $INPUT ]; then
+            ./scanner-bench-gen $kind $BENCH_SIZE > $INPUT || exit 1
+        fi
+    fi
+
+    bench $INPUT
+done
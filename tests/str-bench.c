@@ -0,0 +1,110 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/str.h"
+
+/* Micro-benchmarks of str_* functions, build and run with `make bench-str`,
+ * every benchmark prints time of single operation */
+
+#define ROUNDS 2000000
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double start, unsigned long ops, unsigned long check)
+{
+    // check is printed so compiler cannot drop the work
+    printf("%-28s %8.2f ns/op   (%lu)\n", name, (now() - start) * 1e9 / ops, check);
+}
+
+int main()
+{
+    unsigned long check = 0;
+    double start;
+
+    // one long string built character by character (scanner lexemes)
+    start = now();
+    string_t s;
+    str_init(&s);
+    for (unsigned long i = 0; i < ROUNDS * 10UL; i++) {
+        str_add_char(&s, 'a' + i % 26);
+    }
+    check = s.length;
+    str_free(&s);
+    report("str_add_char (long string)", start, ROUNDS * 10UL, check);
+
+    // one long string built from short pieces (generated instructions)
+    start = now();
+    str_init(&s);
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        str_insert(&s, "pushs LF@");
+    }
+    check = s.length;
+    str_free(&s);
+    report("str_insert (long string)", start, ROUNDS, check);
+
+    // short heap string created, filled and freed
+    start = now();
+    check = 0;
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        str_init(&s);
+        str_insert(&s, "main$1$0$");
+        str_insert(&s, "counter");
+        check += s.length;
+        str_free(&s);
+    }
+    report("short string (heap)", start, ROUNDS, check);
+
+    // short string in stack buffer, no allocation
+    start = now();
+    check = 0;
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        STR_BUFFERED(b);
+        str_insert(&b, "main$1$0$");
+        str_insert(&b, "counter");
+        check += b.length;
+        str_free(&b);
+    }
+    report("short string (buffered)", start, ROUNDS, check);
+
+    // integers and doubles appended to short string
+    start = now();
+    check = 0;
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        STR_BUFFERED(b);
+        str_insert_int(&b, (int64_t)i * 7919 - 1000000);
+        check += b.length;
+        str_free(&b);
+    }
+    report("str_insert_int", start, ROUNDS, check);
+
+    start = now();
+    check = 0;
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        STR_BUFFERED(b);
+        str_insert_double(&b, i * 0.37 + 1e-3);
+        check += b.length;
+        str_free(&b);
+    }
+    report("str_insert_double", start, ROUNDS, check);
+
+    // copy of medium string
+    start = now();
+    check = 0;
+    string_t src = str_view("move LF@main$0$counter int@1234567", 34);
+    str_init(&s);
+    for (unsigned long i = 0; i < ROUNDS; i++) {
+        str_copy(&src, &s);
+        check += s.length;
+    }
+    str_free(&s);
+    report("str_copy", start, ROUNDS, check);
+
+    return 0;
+}